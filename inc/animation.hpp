@@ -0,0 +1,33 @@
+#ifndef ANIMATION_INCLUDED
+	#include <cstdint>
+	#include <cstdio>
+	
+	#define ANIM_FRAME_RATE 24
+	#define ANIM_DEFAULT_LENGTH 48
+	
+	namespace anim{
+		// Keyframes
+		void key(unsigned char bone);
+		bool unkey(unsigned char bone);
+		unsigned int keyCount();
+		
+		// Timeline
+		void setLength(unsigned int frames);
+		unsigned int length();
+		
+		void seek(unsigned int frame);
+		unsigned int frame();
+		
+		// Playback
+		void play();
+		void stop();
+		bool playing();
+		
+		bool update();
+		
+		// Baked export
+		bool exportBaked(FILE *out);
+	}
+	
+	#define ANIMATION_INCLUDED
+#endif
@@ -14,13 +14,14 @@
 	#define CLR_RANBW_NULL 8
 	#define CLR_RANBW_COUNT 9
 	
+	// Alpha of solid strokes, also the wireframe shader's outline floor
+	#define CLR_ALPHA_SOLID 176
+	
 	namespace clr{
 		enum profile{
 			PFL_WHITE,
 			PFL_EDITR,
-			PFL_EDITR_SOL,
 			PFL_RANBW,
-			PFL_RANBW_SOL,
 			
 			PFL_COUNT
 		};
@@ -3,13 +3,16 @@
 	
 	#include "colors.hpp"
 	
+	// Palettes are banks of custom colors, each layer drawing with one of them
+	#define CLR_CSTM_PALETTE_COUNT 8
+	
 	namespace clrCstm{
 		void init();
 		
-		void set(unsigned char index,uint32_t newColor);
-		uint32_t get(unsigned char index);
+		void set(unsigned char palette,unsigned char index,uint32_t newColor);
+		uint32_t get(unsigned char palette,unsigned char index);
 		
-		void apply(enum clr::profile colorProfile,unsigned char colorProfileMember,enum clr::alpha colorAlpha);
+		void apply(unsigned char palette,enum clr::profile colorProfile,unsigned char colorProfileMember,enum clr::alpha colorAlpha);
 	}
 	
 	#define COLORS_CUSTOM_INCLUDED
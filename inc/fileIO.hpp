@@ -17,6 +17,11 @@
 			bool read(int16_t *val,FILE *in);
 			bool write(int16_t val,FILE *out);
 		}
+		
+		namespace u32{
+			bool read(uint32_t *val,FILE *in);
+			bool write(uint32_t val,FILE *out);
+		}
 	}
 	
 	#define FILE_IO_INCLUDED
@@ -22,12 +22,23 @@
 		void free();
 		
 		void calculateTargetDimensions();
+		
+		// Asynchronous loading
+		enum loadStatus{
+			LOAD_IDLE,
+			LOAD_BUSY,
+			LOAD_SUCCEEDED,
+			LOAD_FAILED
+		};
 	}
 	
 	namespace render{
 		// Texture
 		namespace tex{
 			bool load(const char *source);
+			bool update();
+			enum graphics::loadStatus loadStatus(unsigned int *percent);
+			
 			void unload();
 			bool isLoaded();
 			
@@ -35,6 +46,14 @@
 			void draw();
 		}
 		
+		// Scene cache, redrawn only when invalidated
+		namespace scene{
+			void invalidate();
+			
+			bool begin();
+			void end(const sf::Window &window);
+		}
+		
 		// Rendering
 		#define VERT_MODE_RAW_XY 1
 		#define VERT_MODE_RAW_UV 2
@@ -48,7 +67,7 @@
 		#define CLR_PFL_RANBW 1
 		#define CLR_PFL_CSTM 2
 		
-		void loadAndDrawTris(struct vecTrisBuf *buf,struct vecTris **tris,unsigned int vert,unsigned int frag,unsigned int pfl,bool wireframe);
+		void loadAndDrawTris(struct vecTrisBuf *buf,struct vecTris **tris,unsigned int vert,unsigned int frag,unsigned int pfl,unsigned char palette,bool wireframe,float offsetX,float offsetY);
 	}
 	
 	namespace hud{
@@ -70,11 +89,14 @@
 		void drawHelp(enum mesherState state);
 		void drawBottomBar(const char *line,bool snapOn,bool showTris,unsigned char currTri);
 		void drawLayerNav(std::vector<class vertLayer *> &layers,unsigned int currLayer,const char *altCurrLayerName,class gridLayer *grid,const char *altGridDisplay);
-		void drawCustomColorsRef(unsigned char currColor,const char *altCurrColorHex);
+		void drawCustomColorsRef(unsigned char palette,unsigned char currColor,const char *altCurrColorHex);
 		void drawVBonesRef(unsigned char currBone);
 		void drawBonesRef(unsigned char currBone,const char *altCurrBoneParent);
 		
 		// Drawing Dynamic Model-State-Dependant UI
+		// Batched until the next flush, which any non-batched drawing performs first
+		void flush();
+		
 		void drawCircle(int32_t x,int32_t y,bool isRadNorm,float radius,uint32_t color);
 		void drawCircleOutline(int32_t x,int32_t y,bool isRadNorm,float radius,uint32_t color);
 		
@@ -88,10 +110,16 @@
 		};
 		
 		void drawLine(enum lineType type,int16_t x,int16_t y,float len,uint32_t color);
+		void drawGrid(unsigned int divisions,uint32_t color);
 		
 		// Reference
 		namespace ref{
 			bool load(const char *source);
+			bool update();
+			bool streaming();
+			enum graphics::loadStatus loadStatus(unsigned int *percent);
+			const char *storeNote();
+			
 			void unload();
 			
 			void toggleSmooth();
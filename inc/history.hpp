@@ -0,0 +1,59 @@
+#ifndef HISTORY_INCLUDED
+	#include <cstdint>
+	#include <cstddef>
+	#include <vector>
+	
+	#define HIST_DEFAULT_BUDGET_BYTES (64 * 1024 * 1024)
+	
+	enum histOp{
+		HIST_XY,
+		HIST_UV,
+		HIST_COLOR,
+		HIST_BONE,
+		HIST_SEL,
+		HIST_TRI_DELETE,
+		HIST_TRI_APPEND
+	};
+	
+	// One layer's change, applied by the layer itself
+	// Value records swap their stored values with the layer's, so undoing and redoing are the same operation
+	struct histRecord{
+		class vertLayer *target = NULL;
+		enum histOp op = HIST_XY;
+		
+		// First triangle for triangle records
+		uint32_t index = 0;
+		uint32_t count = 0;
+		
+		// Vertex indices with their values, or selection word indices with their XOR bits
+		std::vector<uint32_t> indices;
+		std::vector<uint16_t> values;
+		std::vector<uint64_t> bits;
+	};
+	
+	namespace hist{
+		// Takes the record's contents, leaving it empty
+		void record(struct histRecord &rec);
+		
+		// Closes the current step, if anything was recorded into it
+		void commit();
+		
+		bool undo();
+		bool redo();
+		
+		void budgetSet(size_t bytes);
+		size_t budget();
+		size_t used();
+		
+		// False while the one step always kept is alone over budget
+		bool budgetMet();
+		
+		unsigned int undoable();
+		unsigned int redoable();
+		
+		// Drops every record of a layer about to be deleted
+		void forget(class vertLayer *target);
+	}
+	
+	#define HISTORY_INCLUDED
+#endif
@@ -0,0 +1,20 @@
+#ifndef INVERSE_KINEMATICS_INCLUDED
+	#include <cstdint>
+	
+	#define IK_BUDGET_MICROSECONDS 2000
+	
+	namespace ik{
+		// Chain from the end bone up to its root
+		bool begin(unsigned char endBone);
+		void target(int32_t x,int32_t y);
+		
+		// Resumes from the last solution, returning whether the pose changed
+		bool solve();
+		bool solving();
+		
+		void commit();
+		void cancel();
+	}
+	
+	#define INVERSE_KINEMATICS_INCLUDED
+#endif
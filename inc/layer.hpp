@@ -9,6 +9,7 @@
 	}
 	
 	#include "state.hpp"
+	#include "history.hpp"
 	
 	#define LAYER_NAME_STRLEN 10
 	
@@ -52,22 +53,61 @@
 			virtual void draw() = 0;
 	};
 	
+	// Vertex streams shared by linked layers, copied by whichever writes first
+	struct layerMesh{
+		unsigned char *arena;
+		size_t arenaBytes;
+		uint32_t maxTris;
+		
+		unsigned int refs;
+		
+		// Display of the unaltered mesh, drawn by every linked layer
+		std::vector<struct vecTris *> tris;
+		bool trisStale;
+		
+		// Triangle range written since the display's last upload
+		uint32_t dirtyFirst,dirtyEnd;
+	};
+	
 	class vertLayer: public layer{
 		private:
-			// Parameters
-			unsigned int maxTris;
+			// Parameters, vecTrisBuf's own u16 count left unused past per-chunk views
+			uint32_t maxTris;
+			uint32_t triCount;
+			
+			// Shared mesh backing buffer, single private allocation backing disp and selVerts
+			struct layerMesh *mesh;
+			
+			unsigned char *arena;
+			size_t arenaBytes;
+			unsigned char palette = 0;
+			
+			// Instance placement in view
+			int16_t offsetX = 0;
+			int16_t offsetY = 0;
 			
 			// Buffers and Displays
 			struct vecTrisBuf buffer,disp;
-			struct vecTris *dispTris;
+			std::vector<struct vecTris *> dispTris;
 			bool modified;
 			
+			// Triangle range of the display to update, short of a whole modification
+			uint32_t dirtyFirst = 0;
+			uint32_t dirtyEnd = 0;
+			
+			// Brush hits, as vertex indices
+			std::vector<uint32_t> brushHits;
+			
+			// Posed vertex positions, as x/y pairs
+			std::vector<int32_t> skinned;
+			
 			// Draw State Tracking
 			enum drawState lastDraw;
 			unsigned char lastBone;
 			
 			// Vertex Modifiers
 			void (*vertModifier)(int16_t*,int16_t*);
+			void (*vertModifierBatch)(int16_t*,const unsigned char*,unsigned int,uint16_t);
 			bool (*vertModifierEnabled)();
 			
 			// Nearest Elements
@@ -85,14 +125,27 @@
 			bool NEARTRI_VALID();
 			
 			// Utility methods ---------------------
-			bool readMesh(FILE *in);
+			bool readMesh(FILE *in,uint16_t shortCount);
 			
 			bool init_ReadLayer(FILE *in);
 			void init_Blank(unsigned int maxTriCount);
 			
+			void arenaSet(uint32_t capacity);
+			
+			void meshOwn();
+			void meshWrite();
+			void meshWrite(uint32_t firstTri,uint32_t endTri);
+			bool meshShared();
+			
 			void end();
+			void grow(uint32_t minTriCount);
 			
 			void copyTri(struct vecTrisBuf *src,unsigned int srcI,struct vecTrisBuf *dest,unsigned int destI);
+			void tri_Delete(unsigned int t);
+			
+			void tri_Pack(unsigned int t,uint16_t *out);
+			void tri_Unpack(unsigned int t,const uint16_t *in);
+			void hist_RecordSelect(unsigned int first,unsigned int count,bool newState);
 			
 			unsigned int renderVertMode();
 			unsigned int renderFragMode();
@@ -101,9 +154,14 @@
 			sf::Vector2<int32_t> modedVertPosition(unsigned int i);
 			void vertModifiers_ApplyTo(struct vecTrisBuf *vertModified);
 			
+			void dispUpdate(uint32_t firstTri,uint32_t endTri,unsigned char currBone);
+			
+			void brush_Paint(int16_t x,int16_t y,unsigned int radius,bool selectedOnly,enum histOp op,unsigned char value);
+			
 		public:
 			// General Globals ---------------------
 			vertLayer(unsigned int maxTriCount,FILE *in,bool *readSuccess);
+			vertLayer(class vertLayer *src);
 			~vertLayer();
 			
 			enum layerType type();
@@ -112,8 +170,19 @@
 			bool writeMesh(FILE *out);
 			bool writeLayer(FILE *out);
 			
+			// Custom color palette ------------------
+			void paletteSet(unsigned char newPalette);
+			unsigned char paletteGet();
+			
+			// Instancing ------------------
+			void offsetSet(int16_t x,int16_t y);
+			int16_t offsetGetX();
+			int16_t offsetGetY();
+			
+			bool linked();
+			
 			// Vertex Modifiers ------------------
-			void vertModifiers_Set(void (*mod)(int16_t*,int16_t*),bool (*modEnabled)());
+			void vertModifiers_Set(void (*mod)(int16_t*,int16_t*),void (*modBatch)(int16_t*,const unsigned char*,unsigned int,uint16_t),bool (*modEnabled)());
 			bool vertModifiers_Applicable();
 			void vertModifiers_Apply();
 			
@@ -130,7 +199,8 @@
 			static class vertLayer *withNearestPoint(std::vector<class vertLayer *> &layers);
 			
 			void draw();
-			void draw(unsigned char currBone,bool wireframe,bool showNearestPoint);
+			void draw(unsigned char currBone,bool wireframe);
+			void drawNearestPoint();
 			
 			// Selections ---------------------
 			bool selectVert_Nearest(bool toggle,bool set);
@@ -141,9 +211,20 @@
 			void nearVert_SetColor(unsigned char color);
 			void nearVert_SetBone(unsigned char bone);
 			
+			// Every vertex within the radius of x/y, optionally only those selected
+			void brush_SetColor(int16_t x,int16_t y,unsigned int radius,bool selectedOnly,unsigned char color);
+			void brush_SetBone(int16_t x,int16_t y,unsigned int radius,bool selectedOnly,unsigned char bone);
+			
 			void nearTri_Delete();
 			
+			void tris_Reserve(uint32_t count);
 			void tris_Add(int16_t x0,int16_t y0,int16_t x1,int16_t y1,int16_t x2,int16_t y2,unsigned char type);
+			
+			// Interleaved x/y of count triangles, UVs matching their positions
+			void tris_Append(const int16_t *xy,uint32_t count,unsigned char type);
+			
+			// History ---------------------
+			void hist_Apply(struct histRecord &rec,bool undo);
 	};
 	
 	class gridLayer: public layer{
@@ -0,0 +1,26 @@
+#ifndef POSE_LIBRARY_INCLUDED
+	#include <cstdint>
+	#include <cstdio>
+	
+	#define POSE_LIBRARY_SLOT_COUNT 8
+	#define POSE_NAME_STRLEN 16
+	
+	namespace poseLib{
+		// Slots
+		void store(unsigned int slot,const char *name);
+		bool recall(unsigned int slot);
+		
+		bool used(unsigned int slot);
+		const char *name(unsigned int slot);
+		
+		// Blending: weights holds BONES_MAX_COUNT per-bone weights per slot, normalized per bone
+		bool blend(const unsigned int *slots,const float *weights,unsigned int count);
+		bool blend(unsigned int slotA,unsigned int slotB,float t);
+		
+		// File I/O
+		bool write(FILE *out);
+		bool read(FILE *in);
+	}
+	
+	#define POSE_LIBRARY_INCLUDED
+#endif
@@ -3,8 +3,14 @@
 	
 	#include <SFML/Graphics.hpp>
 	
+	extern "C" {
+		#include <vecGL/vecTris.h>
+	}
+	
 	#include "transformOp.hpp"
 	
+	#define SKIN_BENCHMARK_DEFAULT_VERTS (1 << 20)
+	
 	namespace bones{
 		void init();
 		
@@ -28,9 +34,26 @@
 		sf::Vector2<int32_t> getBonePosition(unsigned char bone);
 		sf::Vector2<int32_t> getPointPosition(unsigned char bone,int16_t x,int16_t y);
 		
+		// Batch of getPointPosition over a buffer's vertices, written as x/y pairs
+		void skinVerts(const struct vecTrisBuf *buf,unsigned int first,unsigned int count,int32_t *outXY);
+		
+		// Throughput of skinVerts in millions of vertices per second, over bones in runs and mixed per vertex
+		void skinBenchmark(unsigned int vertCount,double *runMVerts,double *mixedMVerts);
+		
 		void update();
 		void upload();
+		void reupload();
 		void draw();
+		
+		// Animation sampling
+		unsigned int revision();
+		void edited();
+		
+		void getLocal(unsigned char bone,int32_t *translateX,int32_t *translateY,float *scale,float *rotation);
+		void setLocal(unsigned char bone,int32_t translateX,int32_t translateY,float scale,float rotation);
+		
+		void getGlobals(sf::Transform *out);
+		void setGlobals(const sf::Transform *in);
 	}
 	
 	#define SKELETON_INCLUDED
@@ -19,6 +19,7 @@
 		STATE_ATOP_LAYER_NAME,
 		STATE_ATOP_BONE_PARENT_SET,
 		STATE_ATOP_TRANSFORM_POSE,
+		STATE_ATOP_IK_POSE,
 		
 		TOTAL_STATE_COUNT
 	};
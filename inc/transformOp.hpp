@@ -27,6 +27,10 @@
 		float valScalar();
 		
 		void apply(int16_t *x,int16_t *y);
+		
+		// Interleaved x/y pairs, only those with a nonzero mask entry, each value XORed with flip on the way in and out
+		void applyBatch(int16_t *xy,const unsigned char *mask,unsigned int count,uint16_t flip);
+		
 		void exit();
 		
 		void drawUI();
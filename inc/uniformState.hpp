@@ -0,0 +1,24 @@
+#ifndef UNIFORM_STATE_INCLUDED
+	#include <cstdint>
+	
+	// Redundancy-filtering wrappers around vecGL's uniform uploads
+	namespace unif{
+		void invalidate();
+		
+		void position(float x,float y);
+		void fParamsV(float x,float y,float z,float w);
+		void ssr(float x,float y,float r);
+		
+		void color(uint32_t c);
+		void colorArray(const uint32_t *colors,unsigned int count,unsigned int version);
+		
+		void vertFragModes(unsigned int vert,unsigned int frag);
+		
+		// Statistics
+		unsigned long issued();
+		unsigned long skipped();
+		void statsReset();
+	}
+	
+	#define UNIFORM_STATE_INCLUDED
+#endif
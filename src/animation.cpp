@@ -0,0 +1,281 @@
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+extern "C" {
+	#include <vecGL/bones.h>
+}
+
+#include "animation.hpp"
+#include "skeleton.hpp"
+#include "fileIO.hpp"
+
+struct animKey{
+	unsigned int frame;
+	
+	int32_t translateX,translateY;
+	float scale,rotation;
+};
+
+namespace anim{
+	// Keyframes, sorted by frame per bone
+	std::vector<struct animKey> tracks[BONES_MAX_COUNT];
+	
+	// Timeline
+	unsigned int frameCount = ANIM_DEFAULT_LENGTH;
+	unsigned int currFrame = 0;
+	
+	bool isPlaying = false;
+	unsigned int playStartFrame;
+	sf::Clock playClock;
+	
+	// Sampled global bone transforms per frame, valid for one skeleton revision
+	std::vector<sf::Transform> sampleCache;
+	std::vector<bool> sampleCached;
+	unsigned int sampleRevision;
+	
+	void invalidate(){
+		sampleCache.resize(frameCount * BONES_MAX_COUNT);
+		sampleCached.assign(frameCount,false);
+		
+		sampleRevision = pose::revision();
+	}
+	
+	// Sampling ---------------------------------------------------
+	bool sample(unsigned char bone,unsigned int f,struct animKey *out){
+		std::vector<struct animKey> &track = tracks[bone];
+		
+		if(track.empty()){
+			return false;
+		}
+		
+		// Held before the first and after the last key
+		if(f <= track.front().frame){
+			*out = track.front();
+			return true;
+		}
+		
+		if(f >= track.back().frame){
+			*out = track.back();
+			return true;
+		}
+		
+		// Linear interpolation between the surrounding keys
+		unsigned int i = 1;
+		
+		while(track[i].frame < f){
+			++i;
+		}
+		
+		const struct animKey &a = track[i - 1];
+		const struct animKey &b = track[i];
+		
+		float t = (float)(f - a.frame) / (float)(b.frame - a.frame);
+		
+		out->frame = f;
+		out->translateX = a.translateX + (int32_t)((float)(b.translateX - a.translateX) * t);
+		out->translateY = a.translateY + (int32_t)((float)(b.translateY - a.translateY) * t);
+		out->scale = a.scale + (b.scale - a.scale) * t;
+		out->rotation = a.rotation + (b.rotation - a.rotation) * t;
+		
+		return true;
+	}
+	
+	void apply(unsigned int f){
+		struct animKey sampled;
+		bool keyed = false;
+		
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			if(sample(i,f,&sampled)){
+				pose::setLocal(i,sampled.translateX,sampled.translateY,sampled.scale,sampled.rotation);
+				keyed = true;
+			}
+		}
+		
+		if(!keyed){
+			return;
+		}
+		
+		// Any skeleton or live pose change since sampling voids the cache
+		if(sampleRevision != pose::revision() || sampleCached.size() != frameCount){
+			invalidate();
+		}
+		
+		if(sampleCached[f]){
+			pose::setGlobals(&sampleCache[f * BONES_MAX_COUNT]);
+		}else{
+			pose::update();
+			pose::getGlobals(&sampleCache[f * BONES_MAX_COUNT]);
+			
+			sampleCached[f] = true;
+		}
+	}
+	
+	// Keyframes ---------------------------------------------------
+	void key(unsigned char bone){
+		std::vector<struct animKey> &track = tracks[bone & BONE_INDEX_MASK];
+		
+		struct animKey newKey;
+		newKey.frame = currFrame;
+		pose::getLocal(bone,&newKey.translateX,&newKey.translateY,&newKey.scale,&newKey.rotation);
+		
+		std::vector<struct animKey>::iterator it = track.begin();
+		
+		while(it != track.end() && it->frame < currFrame){
+			++it;
+		}
+		
+		if(it != track.end() && it->frame == currFrame){
+			*it = newKey;
+		}else{
+			track.insert(it,newKey);
+		}
+		
+		invalidate();
+	}
+	
+	bool unkey(unsigned char bone){
+		std::vector<struct animKey> &track = tracks[bone & BONE_INDEX_MASK];
+		
+		for(std::vector<struct animKey>::iterator it = track.begin();it != track.end();++it){
+			if(it->frame == currFrame){
+				track.erase(it);
+				invalidate();
+				
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	
+	unsigned int keyCount(){
+		unsigned int count = 0;
+		
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			count += tracks[i].size();
+		}
+		
+		return count;
+	}
+	
+	// Timeline ---------------------------------------------------
+	void setLength(unsigned int frames){
+		// Bounded by the baked format's u16 frame count
+		frameCount = frames < 1 ? 1 : (frames > UINT16_MAX ? UINT16_MAX : frames);
+		currFrame = currFrame < frameCount ? currFrame : frameCount - 1;
+		
+		invalidate();
+	}
+	
+	unsigned int length(){
+		return frameCount;
+	}
+	
+	void seek(unsigned int f){
+		currFrame = f < frameCount ? f : frameCount - 1;
+		apply(currFrame);
+	}
+	
+	unsigned int frame(){
+		return currFrame;
+	}
+	
+	// Playback ---------------------------------------------------
+	void play(){
+		isPlaying = true;
+		playStartFrame = currFrame;
+		playClock.restart();
+	}
+	
+	void stop(){
+		isPlaying = false;
+	}
+	
+	bool playing(){
+		return isPlaying;
+	}
+	
+	bool update(){
+		if(!isPlaying){
+			return false;
+		}
+		
+		// Fixed rate, looping
+		unsigned int f = (playStartFrame + (unsigned int)(playClock.getElapsedTime().asSeconds() * ANIM_FRAME_RATE)) % frameCount;
+		
+		if(f == currFrame){
+			return false;
+		}
+		
+		currFrame = f;
+		apply(currFrame);
+		
+		return true;
+	}
+	
+	// Baked export ---------------------------------------------------
+	// Format, big-endian:
+	//   u16 bone count, u16 frame count, u16 frame rate
+	//   u32 linear scale, u32 translation scale (IEEE floats)
+	//   per frame, per bone: s16 a, b, c, d, tx, ty
+	// The values are the 2x3 affine columns of the mat3s uploaded by pose::upload,
+	// each quantized as value / scale * INT16_MAX
+	bool writeScale(float scale,FILE *out){
+		uint32_t bits;
+		memcpy(&bits,&scale,sizeof(bits));
+		
+		return fIO::u32::write(bits,out);
+	}
+	
+	int16_t quantize(float val,float scale){
+		float q = roundf(val / scale * (float)INT16_MAX);
+		
+		return q > INT16_MAX ? INT16_MAX : (q < -INT16_MAX ? -INT16_MAX : (int16_t)q);
+	}
+	
+	bool exportBaked(FILE *out){
+		// Sample every frame through the cache
+		std::vector<sf::Transform> baked(frameCount * BONES_MAX_COUNT);
+		
+		for(unsigned int f = 0;f < frameCount;++f){
+			apply(f);
+			pose::update();
+			pose::getGlobals(&baked[f * BONES_MAX_COUNT]);
+		}
+		
+		apply(currFrame);
+		pose::update();
+		
+		// Quantization ranges
+		float linearScale = FLT_MIN;
+		float translationScale = FLT_MIN;
+		
+		for(std::vector<sf::Transform>::iterator it = baked.begin();it != baked.end();++it){
+			const float *m = it->getMatrix();
+			
+			linearScale = fmaxf(linearScale,fmaxf(fmaxf(fabsf(m[0]),fabsf(m[1])),fmaxf(fabsf(m[4]),fabsf(m[5]))));
+			translationScale = fmaxf(translationScale,fmaxf(fabsf(m[12]),fabsf(m[13])));
+		}
+		
+		// Header
+		bool success =
+			fIO::u16::write(BONES_MAX_COUNT,out) && fIO::u16::write(frameCount,out) && fIO::u16::write(ANIM_FRAME_RATE,out) &&
+			writeScale(linearScale,out) && writeScale(translationScale,out);
+		
+		// Atlas
+		for(std::vector<sf::Transform>::iterator it = baked.begin();success && it != baked.end();++it){
+			const float *m = it->getMatrix();
+			
+			success =
+				fIO::s16::write(quantize(m[0],linearScale),out) && fIO::s16::write(quantize(m[1],linearScale),out) &&
+				fIO::s16::write(quantize(m[4],linearScale),out) && fIO::s16::write(quantize(m[5],linearScale),out) &&
+				fIO::s16::write(quantize(m[12],translationScale),out) && fIO::s16::write(quantize(m[13],translationScale),out);
+		}
+		
+		return success;
+	}
+}
@@ -3,30 +3,42 @@ extern "C" {
 }
 
 #include "colorsCustom.hpp"
+#include "uniformState.hpp"
 
 namespace clrCstm{
-	uint32_t colors[COLOR_ARRAY_MAX_COUNT];
+	uint32_t colors[CLR_CSTM_PALETTE_COUNT][COLOR_ARRAY_MAX_COUNT];
+	unsigned int versions[CLR_CSTM_PALETTE_COUNT];
 	
 	void init(){
-		for(unsigned int i = 0;i < COLOR_ARRAY_MAX_COUNT;++i){
-			if(i < CLR_RANBW_COUNT){
-				colors[i] = clr::get(clr::PFL_RANBW,i,clr::ALF_HALF);
-			}else{
-				colors[i] = 0x00000000;
+		for(unsigned int p = 0;p < CLR_CSTM_PALETTE_COUNT;++p){
+			++versions[p];
+			
+			for(unsigned int i = 0;i < COLOR_ARRAY_MAX_COUNT;++i){
+				if(i < CLR_RANBW_COUNT){
+					colors[p][i] = clr::get(clr::PFL_RANBW,i,clr::ALF_HALF);
+				}else{
+					colors[p][i] = 0x00000000;
+				}
 			}
 		}
 	}
 	
-	void set(unsigned char index,uint32_t newColor){
-		colors[index & COLOR_ARRAY_INDEX_MASK] = newColor;
+	void set(unsigned char palette,unsigned char index,uint32_t newColor){
+		palette %= CLR_CSTM_PALETTE_COUNT;
+		
+		colors[palette][index & COLOR_ARRAY_INDEX_MASK] = newColor;
+		++versions[palette];
 	}
 	
-	uint32_t get(unsigned char index){
-		return colors[index & COLOR_ARRAY_INDEX_MASK];
+	uint32_t get(unsigned char palette,unsigned char index){
+		return colors[palette % CLR_CSTM_PALETTE_COUNT][index & COLOR_ARRAY_INDEX_MASK];
 	}
 	
-	void apply(enum clr::profile colorProfile,unsigned char colorProfileMember,enum clr::alpha colorAlpha){
-		uniformColor_u32(clr::get(colorProfile,colorProfileMember,colorAlpha));
-		uniformColorArray_u32((uint32_t *)colors,COLOR_ARRAY_MAX_COUNT);
+	void apply(unsigned char palette,enum clr::profile colorProfile,unsigned char colorProfileMember,enum clr::alpha colorAlpha){
+		palette %= CLR_CSTM_PALETTE_COUNT;
+		
+		// Layers sharing a palette share its upload
+		unif::color(clr::get(colorProfile,colorProfileMember,colorAlpha));
+		unif::colorArray(colors[palette],COLOR_ARRAY_MAX_COUNT,versions[palette]);
 	}
 }
\ No newline at end of file
@@ -54,4 +54,23 @@ namespace fIO{
 			return u16::write((int32_t)val - (int32_t)INT16_MIN,out);
 		}
 	}
+	
+	namespace u32{
+		bool read(uint32_t *val,FILE *in){
+			uint16_t a,b;
+			
+			bool aS = u16::read(&a,in);
+			bool bS = u16::read(&b,in);
+			
+			if(aS && bS){
+				*val = ((uint32_t)a << 16) | (uint32_t)b;
+			}
+			
+			return aS && bS;
+		}
+		
+		bool write(uint32_t val,FILE *out){
+			return u16::write(val >> 16,out) && u16::write(val,out);
+		}
+	}
 }
\ No newline at end of file
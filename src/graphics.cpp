@@ -1,7 +1,22 @@
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <direct.h>
+#endif
 
 #include <GL/glew.h>
 
@@ -16,6 +31,7 @@ extern "C" {
 #include "colorsCustom.hpp"
 #include "geometry.hpp"
 #include "skeleton.hpp"
+#include "uniformState.hpp"
 
 #define STRINGIFY_DEEP(M) #M
 #define STRINGIFY(M) STRINGIFY_DEEP(M)
@@ -23,6 +39,51 @@ extern "C" {
 #define PI 3.14159265358979323846
 
 // Shader customization
+// Vertex modes hand barycentric corners and the triangle type through clip distances, which are never negative and so clip nothing
+#define FRAG_MODE_WIRE_CLR 3
+#define FRAG_MODE_WIRE_CLR_SMPL 4
+#define FRAG_MODE_COVERED_CLR 5
+#define FRAG_MODE_COVERED_CLR_SMPL 6
+
+#define SHADER_BARY_CORNER \
+	"gl_ClipDistance[0] = float(gl_VertexID % 3 == 0);\n" \
+	"gl_ClipDistance[1] = float(gl_VertexID % 3 == 1);\n" \
+	"gl_ClipDistance[2] = float(tbc.x);\n"
+#define SHADER_BARY_CLIP_COUNT 3
+
+#define SHADER_BARY \
+	"vec3 bary = vec3(gl_ClipDistance[0],gl_ClipDistance[1],1.0 - gl_ClipDistance[0] - gl_ClipDistance[1]);\n"
+
+// Analytic coverage in place of multisampling, both distances in pixels:
+// straight edges by their barycentric distance, curves by the quadratic's implicit u * u - v over its gradient,
+// the first corner being the curve's control point as with the convex handles
+#define SHADER_COVERAGE \
+	"vec3 edgeDist = bary / fwidth(bary);\n" \
+	"float coverage = clamp(min(edgeDist.x,min(edgeDist.y,edgeDist.z)) + 0.5,0.0,1.0);\n" \
+	\
+	"vec2 curve = vec2(0.5 * bary.x + bary.z,bary.z);\n" \
+	"vec2 curveGrad = 2.0 * curve.x * vec2(dFdx(curve.x),dFdy(curve.x)) - vec2(dFdx(curve.y),dFdy(curve.y));\n" \
+	"float curveDist = (curve.x * curve.x - curve.y) / max(length(curveGrad),1e-6);\n" \
+	\
+	"float triType = floor(gl_ClipDistance[2] + 0.5);\n" \
+	"if(triType == " STRINGIFY(TRI_TYPE_CONVEX) ".0){\n" \
+		"coverage *= clamp(0.5 - curveDist,0.0,1.0);\n" \
+	"}else if(triType == " STRINGIFY(TRI_TYPE_CONCAVE) ".0){\n" \
+		"coverage *= clamp(0.5 + curveDist,0.0,1.0);\n" \
+	"}\n"
+
+#define SHADER_WIRE_WIDTH "1.5"
+#define SHADER_WIRE_ALPHA "(" STRINGIFY(CLR_ALPHA_SOLID) ".0 / 255.0)"
+
+// Anti-aliased outline weight from the barycentric corners
+// Outlines span the whole triangle, as with unclipped line drawing, so only the fill is covered
+#define SHADER_WIRE_OUTLINE \
+	"vec3 edge = smoothstep(vec3(0.0),fwidth(bary) * " SHADER_WIRE_WIDTH ",bary);\n" \
+	"float outline = 1.0 - min(edge.x,min(edge.y,edge.z));\n" \
+	"if(max(outline,coverage) <= 0.0){\n" \
+		"discard;\n" \
+	"}\n"
+
 const char SHADER_VERT_CASES[] =
 	// 0: Pose XY, fParam-less
 	// Raw XY
@@ -30,6 +91,7 @@ const char SHADER_VERT_CASES[] =
 		"XY = (position + xy * fParamsV.xy) * ssr.xy * rotater(ssr.z);\n"
 		"UV = uv;\n"
 		"RGBA = indexColor(tbc.z);\n"
+		SHADER_BARY_CORNER
 		
 		"break;\n"
 	// Raw UV
@@ -37,6 +99,7 @@ const char SHADER_VERT_CASES[] =
 		"XY = (position + ((uv * 2.0) - vec2(1.0,1.0)) * fParamsV.xy) * ssr.xy * rotater(ssr.z);\n"
 		"UV = uv;\n"
 		"RGBA = indexColor(tbc.z);\n"
+		SHADER_BARY_CORNER
 		
 		"break;\n"
 	// Pose XY
@@ -44,6 +107,7 @@ const char SHADER_VERT_CASES[] =
 		"XY = (position + indexPosition(tbc.y) * fParamsV.xy) * ssr.xy * rotater(ssr.z);\n"
 		"UV = uv;\n"
 		"RGBA = indexColor(tbc.z);\n"
+		SHADER_BARY_CORNER
 		
 		"break;\n"
 ;
@@ -60,14 +124,94 @@ const char SHADER_FRAG_CASES[] =
 		"fragClip();\n"
 		"fragColor = RGBA * texture(sampler0,vec2(UV.x,1.0 - UV.y));\n"
 		
+		"break;\n"
+	// Covered Color
+	"case " STRINGIFY(FRAG_MODE_COVERED_CLR) "u:\n"
+		"{\n"
+			SHADER_BARY
+			SHADER_COVERAGE
+			
+			"if(coverage <= 0.0){\n"
+				"discard;\n"
+			"}\n"
+			
+			"fragColor = vec4(RGBA.rgb,RGBA.a * coverage);\n"
+		"}\n"
+		
+		"break;\n"
+	// Covered Color & Sample
+	"case " STRINGIFY(FRAG_MODE_COVERED_CLR_SMPL) "u:\n"
+		"{\n"
+			SHADER_BARY
+			SHADER_COVERAGE
+			
+			"if(coverage <= 0.0){\n"
+				"discard;\n"
+			"}\n"
+			
+			"fragColor = RGBA * texture(sampler0,vec2(UV.x,1.0 - UV.y));\n"
+			"fragColor.a *= coverage;\n"
+		"}\n"
+		
+		"break;\n"
+	// Wireframe: half-alpha covered fill with an anti-aliased outline
+	"case " STRINGIFY(FRAG_MODE_WIRE_CLR) "u:\n"
+		"{\n"
+			SHADER_BARY
+			SHADER_COVERAGE
+			SHADER_WIRE_OUTLINE
+			
+			"fragColor = mix(vec4(RGBA.rgb,RGBA.a * 0.5 * coverage),vec4(RGBA.rgb,max(RGBA.a," SHADER_WIRE_ALPHA ")),outline);\n"
+		"}\n"
+		
+		"break;\n"
+	// Wireframe & Sample: as above, the fill sampled
+	"case " STRINGIFY(FRAG_MODE_WIRE_CLR_SMPL) "u:\n"
+		"{\n"
+			SHADER_BARY
+			SHADER_COVERAGE
+			SHADER_WIRE_OUTLINE
+			
+			"vec4 fill = RGBA * texture(sampler0,vec2(UV.x,1.0 - UV.y));\n"
+			"fragColor = mix(vec4(fill.rgb,fill.a * 0.5 * coverage),vec4(RGBA.rgb,max(RGBA.a," SHADER_WIRE_ALPHA ")),outline);\n"
+		"}\n"
+		
 		"break;\n"
 ;
 
+// Grid shader: lines sit on the integer texture coordinates 0 to count
+const char GRID_SHADER_FRAG[] =
+	"uniform float count;\n"
+	"uniform float lineWidth;\n"
+	"uniform vec4 color;\n"
+	
+	"void main(){\n"
+		"vec2 cell = gl_TexCoord[0].xy;\n"
+		"vec2 pixel = fwidth(cell);\n"
+		
+		// Pixel distance to the nearest line, covered across its width
+		"vec2 dist = abs(cell - clamp(floor(cell + 0.5),0.0,count)) / pixel;\n"
+		"vec2 line = clamp(lineWidth * 0.5 + 0.5 - dist,0.0,1.0);\n"
+		
+		// Lines end at the grid's outer edges
+		"vec2 span = clamp(min(cell,count - cell) / pixel + 0.5,0.0,1.0);\n"
+		
+		"gl_FragColor = vec4(color.rgb,color.a * max(line.x * span.y,line.y * span.x));\n"
+	"}\n"
+;
+
 // Target
 sf::RenderTarget *target;
 float viewWidth,viewHeight;
 float minX,maxX,minY,maxY;
 
+// Scene cache
+sf::Texture sceneCache;
+sf::Sprite sceneCacheSprite;
+bool sceneCacheValid = false;
+
+GLuint sceneCacheFbo = 0;
+
 // Shapes
 enum markType{
 	MARK_CIRCLE,
@@ -81,16 +225,25 @@ enum markType{
 sf::RectangleShape center,vLine,hLine;
 sf::RectangleShape hudBack,hudHilight,colorBack;
 
-sf::CircleShape circle,circleOutline;
+sf::CircleShape circle;
 sf::ConvexShape triangle,rhombus,square;
 sf::Shape *marks[MARK_COUNT];
 
 sf::ConvexShape stem;
 sf::ConvexShape wedge;
 
+sf::Shader gridShader;
+bool gridShaderLoaded = false;
+
 #define CENTER_DIM 15.0
 #define LINE_WIDTH 2.0
 
+// Primitive batch: dynamic HUD shapes are collected as triangles and flushed in one draw
+#define CIRCLE_POINT_COUNT 64
+
+std::vector<sf::Vertex> primBatch;
+sf::Vector2f unitCircle[CIRCLE_POINT_COUNT];
+
 // Text ------------------------------------------------------------
 #define HUD_CHAR_SIZE 18
 
@@ -136,7 +289,8 @@ sf::Text mesherStateTitles[TOTAL_STATE_COUNT] = {
 	HUD_TEXT("<Grid Set>"),			// STATE_ATOP_GRID_SET
 	HUD_TEXT("<Layer Name>"),		// STATE_ATOP_LAYER_NAME
 	HUD_TEXT("<Parent Set>"),		// STATE_ATOP_BONE_PARENT_SET
-	HUD_TEXT("<Transform Pose>")	// STATE_ATOP_TRANSFORM_POSE
+	HUD_TEXT("<Transform Pose>"),	// STATE_ATOP_TRANSFORM_POSE
+	HUD_TEXT("<Pose IK>")			// STATE_ATOP_IK_POSE
 };
 
 sf::Text mesherHelpTitleUnderline = HUD_TEXT(std::string(40,' '));
@@ -147,6 +301,8 @@ sf::Text mesherHelpGenerals[4] = {
 	HUD_TEXT(
 		"q+esc:      quit\n"
 		"ctrl+[1-9]: change mode\n"
+		"ctrl+z:     undo\n"
+		"ctrl+y:     redo\n"
 		"\n"
 		"RM:    pan              ctrl+up:     move to layer above\n"
 		"0:     reset view       ctrl+down:   move to layer below\n"
@@ -205,14 +361,21 @@ sf::Text mesherHelpStates[STATE_COUNT] = {
 	// STATE_VERT_UV
 	HUD_TEXT("\n"),
 	// STATE_VERT_COLOR
-	HUD_TEXT("\n"),
+	HUD_TEXT(
+		"alt+LM:       paint within radius\n"
+		"alt+shift+LM: paint selected within radius\n"
+	),
 	// STATE_VERT_BONE
-	HUD_TEXT("\n"),
+	HUD_TEXT(
+		"alt+LM:       paint within radius\n"
+		"alt+shift+LM: paint selected within radius\n"
+	),
 	// STATE_LAYERS
 	HUD_TEXT(
 		"alt+a+up:    add layer above current\n"
 		"alt+a+down:  add layer below current\n"
 		"alt+d:       delete current layer\n"
+		"alt+c:       duplicate (linked) current layer\n"
 	),
 	// STATE_BONES
 	HUD_TEXT("\n"),
@@ -238,45 +401,956 @@ sf::Vector2f helpGeneralDimensions[4];
 sf::Vector2f helpStateDimensions[STATE_COUNT];
 
 // Loadable texture class
+#define TEX_UPLOAD_STEP_BYTES (4 * 1024 * 1024)
+
+enum loadStage{
+	STAGE_IDLE,
+	STAGE_DECODING,
+	STAGE_DECODED,
+	STAGE_UPLOADING,
+	STAGE_SUCCEEDED,
+	STAGE_FAILED
+};
+
 class loadableTexture{
 	private:
 		bool loaded;
-		sf::Texture texture;
+		bool scaleUniformly;
+		
+		// Front texture is displayed, back texture is staged into
+		sf::Texture textures[2];
+		unsigned int front;
+		
 		sf::Sprite sprite;
 		
+		// Asynchronous loading
+		sf::Thread decoder;
+		sf::Mutex stageMutex;
+		
+		enum loadStage stage;
+		bool stageCancelled;
+		
+		std::string stageSource;
+		sf::Image stageImage;
+		unsigned int stageRow;
+		
+		enum loadStage getStage(){
+			sf::Lock lock(stageMutex);
+			return stage;
+		}
+		
+		void setStage(enum loadStage newStage){
+			sf::Lock lock(stageMutex);
+			stage = newStage;
+		}
+		
+		void decode(){
+			// Runs on the decoder thread; touches nothing but the staged image
+			bool decoded = stageImage.loadFromFile(stageSource);
+			
+			sf::Lock lock(stageMutex);
+			
+			if(stageCancelled){
+				stage = STAGE_IDLE;
+			}else{
+				stage = decoded ? STAGE_DECODED : STAGE_FAILED;
+			}
+		}
+		
+		void present(){
+			sf::Texture &staged = textures[1 - front];
+			
+			staged.setSmooth(textures[front].isSmooth());
+			staged.generateMipmap();
+			
+			front = 1 - front;
+			loaded = true;
+			
+			sceneCacheValid = false;
+			
+			sprite.setColor(sf::Color(0xffffff80));
+			sprite.setTexture(textures[front],true);
+			sprite.setOrigin(sf::Vector2f(textures[front].getSize()) / 2.0f);
+			
+			sf::Vector2u size = textures[front].getSize();
+			
+			if(scaleUniformly){
+				float maxDim = (float)(size.x > size.y ? size.x : size.y);
+				sprite.setScale(2.0 / maxDim,2.0 / maxDim);
+			}else{
+				sprite.setScale(2.0 / (float)size.x,2.0 / (float)size.y);
+			}
+		}
+		
+	public:
+		loadableTexture():
+			decoder(&loadableTexture::decode,this)
+		{
+			loaded = false;
+			scaleUniformly = false;
+			front = 0;
+			
+			stage = STAGE_IDLE;
+			stageCancelled = false;
+			stageRow = 0;
+		}
+		
+		~loadableTexture(){
+			decoder.wait();
+		}
+		
+		bool load(const char *source,bool uniformScale){
+			switch(getStage()){
+				case STAGE_DECODING:
+				case STAGE_DECODED:
+				case STAGE_UPLOADING:
+					return false;
+				default:
+					break;
+			}
+			
+			// Previous decode has finished by now, but may not have been joined yet
+			decoder.wait();
+			
+			scaleUniformly = uniformScale;
+			stageSource = std::string(source);
+			stageCancelled = false;
+			
+			setStage(STAGE_DECODING);
+			decoder.launch();
+			
+			return true;
+		}
+		
+		bool update(){
+			switch(getStage()){
+				case STAGE_DECODED:
+					{
+						sf::Vector2u size = stageImage.getSize();
+						
+						if(
+							size.x == 0 || size.y == 0 ||
+							size.x > sf::Texture::getMaximumSize() || size.y > sf::Texture::getMaximumSize() ||
+							!textures[1 - front].create(size.x,size.y)
+						){
+							stageImage = sf::Image();
+							setStage(STAGE_FAILED);
+							
+							return false;
+						}
+						
+						stageRow = 0;
+						setStage(STAGE_UPLOADING);
+					}
+					
+					return true;
+				case STAGE_UPLOADING:
+					{
+						// Upload a bounded number of rows per frame to avoid hitches
+						sf::Vector2u size = stageImage.getSize();
+						
+						unsigned int rows = TEX_UPLOAD_STEP_BYTES / (size.x * 4);
+						rows = rows < 1 ? 1 : rows;
+						rows = stageRow + rows > size.y ? size.y - stageRow : rows;
+						
+						textures[1 - front].update(stageImage.getPixelsPtr() + (size_t)stageRow * size.x * 4,size.x,rows,0,stageRow);
+						stageRow += rows;
+						
+						if(stageRow < size.y){
+							return true;
+						}
+						
+						present();
+						
+						stageImage = sf::Image();
+						setStage(STAGE_SUCCEEDED);
+					}
+					
+					return false;
+				case STAGE_DECODING:
+					return true;
+				default:
+					break;
+			}
+			
+			return false;
+		}
+		
+		enum graphics::loadStatus status(unsigned int *percent){
+			*percent = 0;
+			
+			switch(getStage()){
+				case STAGE_DECODING:
+				case STAGE_DECODED:
+					return graphics::LOAD_BUSY;
+				case STAGE_UPLOADING:
+					*percent = (stageRow * 100) / stageImage.getSize().y;
+					
+					return graphics::LOAD_BUSY;
+				case STAGE_SUCCEEDED:
+					setStage(STAGE_IDLE);
+					*percent = 100;
+					
+					return graphics::LOAD_SUCCEEDED;
+				case STAGE_FAILED:
+					setStage(STAGE_IDLE);
+					
+					return graphics::LOAD_FAILED;
+				default:
+					break;
+			}
+			
+			return graphics::LOAD_IDLE;
+		}
+		
+		void unload(){
+			loaded = false;
+			sceneCacheValid = false;
+			
+			// Drop any load in flight as well
+			sf::Lock lock(stageMutex);
+			
+			switch(stage){
+				case STAGE_DECODING:
+					stageCancelled = true;
+					
+					break;
+				case STAGE_DECODED:
+				case STAGE_UPLOADING:
+					stageImage = sf::Image();
+					stage = STAGE_IDLE;
+					
+					break;
+				default:
+					break;
+			}
+		}
+		
+		bool isLoaded(){
+			return loaded;
+		}
+		
+		void toggleSmooth(){
+			if(!loaded){
+				return;
+			}
+			
+			textures[front].setSmooth(!textures[front].isSmooth());
+			sceneCacheValid = false;
+		}
+		
+		void draw(){
+			if(!loaded){
+				return;
+			}
+			
+			hud::flush();
+			
+			target->draw(
+				sprite,
+				sf::RenderStates(
+					sf::Transform().translate(
+						vw::norm::transform().transformPoint(vw::norm::toD(0),vw::norm::toD(0))
+					).scale(
+						vw::norm::getZoomScale(),
+						vw::norm::getZoomScale()
+					)
+				)
+			);
+		}
+		
+		unsigned int glTex(){
+			return textures[front].getNativeHandle();
+		}
+};
+
+// Tiled image class: a mip pyramid of tiles cached on disk beside the source, streamed in as viewed.
+// Sources in unwritable directories have theirs cached in the temp directory, failing that in memory
+#define TILE_SIZE 256
+#define TILE_CACHE_MAX_COUNT 256
+#define TILE_UPLOADS_PER_FRAME 4
+#define TILE_FALLBACK_MAX_LEVELS 8
+
+#define TILE_DIR_SUFFIX ".tiles"
+#define TILE_META_NAME "meta"
+#define TILE_TEMP_PREFIX "mesher-"
+
+#define TILE_KEY(level,x,y) (((uint64_t)(level) << 48) | ((uint64_t)(y) << 24) | (uint64_t)(x))
+
+#ifdef _WIN32
+	#define MAKE_DIRECTORY(path) _mkdir(path)
+	#define TEMP_DIRECTORY_VAR "TEMP"
+	#define TEMP_DIRECTORY_DEFAULT "."
+#else
+	#define MAKE_DIRECTORY(path) mkdir(path,0755)
+	#define TEMP_DIRECTORY_VAR "TMPDIR"
+	#define TEMP_DIRECTORY_DEFAULT "/tmp"
+#endif
+
+enum tileStore{
+	TILE_STORE_SOURCE,
+	TILE_STORE_TEMP,
+	TILE_STORE_DISK_COUNT,
+	
+	TILE_STORE_MEMORY = TILE_STORE_DISK_COUNT
+};
+
+unsigned int tilesAcross(unsigned int pixels){
+	return (pixels + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+std::string tileTempDir(const std::string &source){
+	// Named by an FNV-1a hash of the source path, so each source keeps its own
+	uint64_t hash = 14695981039346656037ULL;
+	
+	for(std::string::const_iterator it = source.begin();it != source.end();++it){
+		hash = (hash ^ (unsigned char)*it) * 1099511628211ULL;
+	}
+	
+	const char *temp = getenv(TEMP_DIRECTORY_VAR);
+	
+	char name[48];
+	sprintf(name,"/" TILE_TEMP_PREFIX "%016llx" TILE_DIR_SUFFIX,(unsigned long long)hash);
+	
+	return std::string(temp != NULL && temp[0] != '\0' ? temp : TEMP_DIRECTORY_DEFAULT) + name;
+}
+
+std::string tilePath(const std::string &dir,unsigned int level,unsigned int x,unsigned int y){
+	char name[48];
+	sprintf(name,"/%u_%u_%u.png",level,x,y);
+	
+	return dir + name;
+}
+
+sf::Image halveImage(const sf::Image &src){
+	// 2x2 box filter, edge pixels repeated on odd dimensions
+	sf::Vector2u size = src.getSize();
+	unsigned int w = (size.x + 1) / 2;
+	unsigned int h = (size.y + 1) / 2;
+	
+	const sf::Uint8 *in = src.getPixelsPtr();
+	std::vector<sf::Uint8> out((size_t)w * h * 4);
+	
+	for(unsigned int y = 0;y < h;++y){
+		size_t row0 = (size_t)(y * 2) * size.x;
+		size_t row1 = (size_t)(y * 2 + 1 < size.y ? y * 2 + 1 : y * 2) * size.x;
+		
+		for(unsigned int x = 0;x < w;++x){
+			size_t col0 = x * 2;
+			size_t col1 = x * 2 + 1 < size.x ? x * 2 + 1 : x * 2;
+			
+			for(unsigned int c = 0;c < 4;++c){
+				unsigned int sum = in[(row0 + col0) * 4 + c] + in[(row0 + col1) * 4 + c] + in[(row1 + col0) * 4 + c] + in[(row1 + col1) * 4 + c];
+				out[((size_t)y * w + x) * 4 + c] = (sum + 2) / 4;
+			}
+		}
+	}
+	
+	sf::Image halved;
+	halved.create(w,h,&out[0]);
+	
+	return halved;
+}
+
+class tiledImage{
+	private:
+		struct tile{
+			uint64_t key;
+			sf::Texture texture;
+		};
+		
+		struct decodedTile{
+			uint64_t key;
+			unsigned int generation;
+			sf::Image *image;
+		};
+		
+		bool loaded;
+		bool smooth;
+		
+		// Displayed pyramid, level 0 being full resolution
+		unsigned int width,height,levels;
+		
+		sf::Sprite sprite;
+		
+		// Pyramid building
+		sf::Thread builder;
+		sf::Mutex buildMutex;
+		
+		enum loadStage stage;
+		bool buildCancelled;
+		
+		std::string buildSource,buildDir;
+		unsigned int buildWidth,buildHeight,buildLevels;
+		unsigned int buildDone,buildTotal;
+		
+		// Where the built pyramid lives, tiles held here when in memory
+		enum tileStore buildStore;
+		std::map<uint64_t,sf::Image> buildTiles;
+		
+		// Tile streaming: decoded on the loader thread, uploaded on this one
+		sf::Thread loader;
+		sf::Mutex streamMutex;
+		
+		std::string streamDir;
+		std::map<uint64_t,sf::Image> streamTiles;
+		enum tileStore streamStore;
+		unsigned int streamGeneration;
+		bool streamRunning;
+		
+		std::deque<uint64_t> requests;
+		std::set<uint64_t> requested;
+		std::vector<struct decodedTile> decoded;
+		
+		// GPU tile cache, most recently used first
+		std::list<struct tile> cache;
+		std::map<uint64_t,std::list<struct tile>::iterator> cacheIndex;
+		
+		enum loadStage getStage(){
+			sf::Lock lock(buildMutex);
+			return stage;
+		}
+		
+		void setStage(enum loadStage newStage){
+			sf::Lock lock(buildMutex);
+			stage = newStage;
+		}
+		
+		bool buildCancelledGet(){
+			sf::Lock lock(buildMutex);
+			return buildCancelled;
+		}
+		
+		// Builder thread -------------------------------
+		bool readMeta(const struct stat &sourceStat){
+			FILE *in = fopen((buildDir + "/" TILE_META_NAME).c_str(),"r");
+			
+			if(in == NULL){
+				return false;
+			}
+			
+			unsigned int tileSize;
+			long long sourceSize,sourceTime;
+			
+			bool valid = 
+				fscanf(in,"%u %u %u %u %lld %lld",&buildWidth,&buildHeight,&buildLevels,&tileSize,&sourceSize,&sourceTime) == 6 &&
+				tileSize == TILE_SIZE && buildLevels > 0 &&
+				sourceSize == (long long)sourceStat.st_size && sourceTime == (long long)sourceStat.st_mtime;
+			
+			fclose(in);
+			
+			return valid;
+		}
+		
+		bool writeMeta(const struct stat &sourceStat){
+			FILE *out = fopen((buildDir + "/" TILE_META_NAME).c_str(),"w");
+			
+			if(out == NULL){
+				return false;
+			}
+			
+			fprintf(out,"%u %u %u %u %lld %lld\n",buildWidth,buildHeight,buildLevels,TILE_SIZE,(long long)sourceStat.st_size,(long long)sourceStat.st_mtime);
+			
+			return fclose(out) == 0;
+		}
+		
+		bool writeTiles(sf::Image level,const std::string &dir){
+			// Directory made or already there, an empty one meaning tiles kept in memory
+			if(!dir.empty() && MAKE_DIRECTORY(dir.c_str()) != 0 && errno != EEXIST){
+				return false;
+			}
+			
+			{
+				sf::Lock lock(buildMutex);
+				buildDone = 0;
+			}
+			
+			buildTiles.clear();
+			
+			for(unsigned int l = 0;l < buildLevels;++l){
+				sf::Vector2u size = level.getSize();
+				
+				for(unsigned int y = 0;y < tilesAcross(size.y);++y){
+					for(unsigned int x = 0;x < tilesAcross(size.x);++x){
+						if(buildCancelledGet()){
+							return false;
+						}
+						
+						unsigned int tw = size.x - x * TILE_SIZE < TILE_SIZE ? size.x - x * TILE_SIZE : TILE_SIZE;
+						unsigned int th = size.y - y * TILE_SIZE < TILE_SIZE ? size.y - y * TILE_SIZE : TILE_SIZE;
+						
+						sf::Image tileImage;
+						tileImage.create(tw,th);
+						tileImage.copy(level,0,0,sf::IntRect(x * TILE_SIZE,y * TILE_SIZE,tw,th));
+						
+						if(dir.empty()){
+							buildTiles[TILE_KEY(l,x,y)] = tileImage;
+						}else if(!tileImage.saveToFile(tilePath(dir,l,x,y))){
+							return false;
+						}
+						
+						sf::Lock lock(buildMutex);
+						++buildDone;
+					}
+				}
+				
+				if(l + 1 < buildLevels){
+					level = halveImage(level);
+				}
+			}
+			
+			return true;
+		}
+		
+		bool buildPyramid(){
+			struct stat sourceStat;
+			
+			if(stat(buildSource.c_str(),&sourceStat) != 0){
+				return false;
+			}
+			
+			std::string dirs[TILE_STORE_DISK_COUNT] = {buildSource + TILE_DIR_SUFFIX,tileTempDir(buildSource)};
+			
+			// Reuse a complete pyramid built from this same source
+			for(unsigned int i = 0;i < TILE_STORE_DISK_COUNT;++i){
+				buildDir = dirs[i];
+				buildStore = (enum tileStore)i;
+				
+				if(readMeta(sourceStat)){
+					return true;
+				}
+			}
+			
+			sf::Image level;
+			
+			if(!level.loadFromFile(buildSource)){
+				return false;
+			}
+			
+			buildWidth = level.getSize().x;
+			buildHeight = level.getSize().y;
+			
+			if(buildWidth == 0 || buildHeight == 0){
+				return false;
+			}
+			
+			// Levels halve until one tile covers the whole image
+			unsigned int w = buildWidth;
+			unsigned int h = buildHeight;
+			unsigned int total = 0;
+			
+			for(buildLevels = 1;;++buildLevels){
+				total += tilesAcross(w) * tilesAcross(h);
+				
+				if(w <= TILE_SIZE && h <= TILE_SIZE){
+					break;
+				}
+				
+				w = (w + 1) / 2;
+				h = (h + 1) / 2;
+			}
+			
+			{
+				sf::Lock lock(buildMutex);
+				buildTotal = total;
+			}
+			
+			// First directory taking the whole pyramid, its meta written last so only complete pyramids are ever reused
+			for(unsigned int i = 0;i < TILE_STORE_DISK_COUNT;++i){
+				buildDir = dirs[i];
+				buildStore = (enum tileStore)i;
+				
+				if(writeTiles(level,buildDir) && writeMeta(sourceStat)){
+					return true;
+				}
+				
+				if(buildCancelledGet()){
+					return false;
+				}
+			}
+			
+			// Neither writable, the pyramid lasting only as long as it is loaded
+			buildDir.clear();
+			buildStore = TILE_STORE_MEMORY;
+			
+			return writeTiles(level,buildDir);
+		}
+		
+		void build(){
+			bool built = buildPyramid();
+			
+			sf::Lock lock(buildMutex);
+			
+			if(buildCancelled){
+				stage = STAGE_IDLE;
+			}else{
+				stage = built ? STAGE_DECODED : STAGE_FAILED;
+			}
+		}
+		
+		// Loader thread -------------------------------
+		void stream(){
+			for(;;){
+				uint64_t key;
+				unsigned int generation;
+				std::string dir;
+				
+				struct decodedTile result;
+				result.image = NULL;
+				
+				{
+					sf::Lock lock(streamMutex);
+					
+					if(requests.empty()){
+						streamRunning = false;
+						return;
+					}
+					
+					key = requests.front();
+					requests.pop_front();
+					
+					generation = streamGeneration;
+					dir = streamDir;
+					
+					// In-memory pyramids need no decoding
+					if(streamStore == TILE_STORE_MEMORY){
+						std::map<uint64_t,sf::Image>::iterator found = streamTiles.find(key);
+						
+						if(found != streamTiles.end()){
+							result.image = new sf::Image(found->second);
+						}
+					}
+				}
+				
+				result.key = key;
+				result.generation = generation;
+				
+				if(!dir.empty()){
+					result.image = new sf::Image();
+					
+					if(!result.image->loadFromFile(tilePath(dir,key >> 48,key & 0xffffff,(key >> 24) & 0xffffff))){
+						delete result.image;
+						result.image = NULL;
+					}
+				}
+				
+				sf::Lock lock(streamMutex);
+				decoded.push_back(result);
+			}
+		}
+		
+		// Tile cache -------------------------------
+		void request(uint64_t key,bool urgent){
+			sf::Lock lock(streamMutex);
+			
+			if(!requested.insert(key).second){
+				return;
+			}
+			
+			if(urgent){
+				requests.push_front(key);
+			}else{
+				requests.push_back(key);
+			}
+			
+			if(!streamRunning){
+				loader.wait();
+				
+				streamRunning = true;
+				loader.launch();
+			}
+		}
+		
+		void clearTiles(){
+			cache.clear();
+			cacheIndex.clear();
+			
+			sf::Lock lock(streamMutex);
+			
+			requests.clear();
+			requested.clear();
+			
+			for(std::vector<struct decodedTile>::iterator it = decoded.begin();it != decoded.end();++it){
+				delete it->image;
+			}
+			
+			decoded.clear();
+			++streamGeneration;
+		}
+		
+		const sf::Texture *cached(uint64_t key){
+			std::map<uint64_t,std::list<struct tile>::iterator>::iterator found = cacheIndex.find(key);
+			
+			if(found == cacheIndex.end()){
+				return NULL;
+			}
+			
+			// Most recently used to the front
+			cache.splice(cache.begin(),cache,found->second);
+			
+			return &(found->second->texture);
+		}
+		
+		void upload(const struct decodedTile &ready){
+			cache.push_front(tile());
+			cache.front().key = ready.key;
+			
+			if(!cache.front().texture.loadFromImage(*ready.image)){
+				cache.pop_front();
+				return;
+			}
+			
+			cache.front().texture.setSmooth(smooth);
+			cacheIndex[ready.key] = cache.begin();
+			
+			while(cache.size() > TILE_CACHE_MAX_COUNT){
+				cacheIndex.erase(cache.back().key);
+				cache.pop_back();
+			}
+			
+			sceneCacheValid = false;
+		}
+		
+		void activate(){
+			clearTiles();
+			
+			{
+				sf::Lock lock(streamMutex);
+				streamDir = buildDir;
+				streamStore = buildStore;
+				
+				streamTiles.clear();
+				streamTiles.swap(buildTiles);
+			}
+			
+			width = buildWidth;
+			height = buildHeight;
+			levels = buildLevels;
+			
+			loaded = true;
+			sceneCacheValid = false;
+		}
+		
+		// Draws the region of a tile with the finest cached level at or above it
+		void drawRegion(unsigned int level,unsigned int x,unsigned int y,sf::Vector2f origin,float pixelScale){
+			for(unsigned int l = level;l < levels && l < level + TILE_FALLBACK_MAX_LEVELS;++l){
+				unsigned int shift = l - level;
+				const sf::Texture *texture = cached(TILE_KEY(l,x >> shift,y >> shift));
+				
+				if(texture == NULL){
+					continue;
+				}
+				
+				// Sub-rectangle of the coarser tile covering the region
+				int sub = TILE_SIZE >> shift;
+				int left = (x & ((1 << shift) - 1)) * sub;
+				int top = (y & ((1 << shift) - 1)) * sub;
+				int w = (int)texture->getSize().x - left < sub ? (int)texture->getSize().x - left : sub;
+				int h = (int)texture->getSize().y - top < sub ? (int)texture->getSize().y - top : sub;
+				
+				if(w <= 0 || h <= 0){
+					return;
+				}
+				
+				float texel = pixelScale * (float)(1 << l);
+				
+				sprite.setTexture(*texture);
+				sprite.setTextureRect(sf::IntRect(left,top,w,h));
+				sprite.setScale(texel,texel);
+				sprite.setPosition(
+					origin.x + pixelScale * ((float)(x * (TILE_SIZE << level)) - width / 2.0f),
+					origin.y + pixelScale * ((float)(y * (TILE_SIZE << level)) - height / 2.0f)
+				);
+				
+				target->draw(sprite);
+				
+				return;
+			}
+		}
+		
 	public:
-		loadableTexture(){
+		tiledImage():
+			builder(&tiledImage::build,this),
+			loader(&tiledImage::stream,this)
+		{
 			loaded = false;
+			smooth = false;
+			
+			width = height = levels = 0;
+			
+			stage = STAGE_IDLE;
+			buildCancelled = false;
+			buildWidth = buildHeight = buildLevels = 0;
+			buildDone = buildTotal = 0;
+			
+			buildStore = TILE_STORE_SOURCE;
+			streamStore = TILE_STORE_SOURCE;
+			
+			streamGeneration = 0;
+			streamRunning = false;
+			
+			sprite.setColor(sf::Color(0xffffff80));
+		}
+		
+		~tiledImage(){
+			{
+				sf::Lock lock(buildMutex);
+				buildCancelled = true;
+			}
+			
+			builder.wait();
+			
+			clearTiles();
+			loader.wait();
+			clearTiles();
+		}
+		
+		bool load(const char *source){
+			switch(getStage()){
+				case STAGE_DECODING:
+				case STAGE_DECODED:
+					return false;
+				default:
+					break;
+			}
+			
+			// Previous build has finished by now, but may not have been joined yet
+			builder.wait();
+			
+			buildSource = std::string(source);
+			buildDir = buildSource + TILE_DIR_SUFFIX;
+			buildCancelled = false;
+			buildDone = buildTotal = 0;
+			
+			setStage(STAGE_DECODING);
+			builder.launch();
+			
+			return true;
+		}
+		
+		bool update(){
+			bool busy = false;
+			
+			switch(getStage()){
+				case STAGE_DECODING:
+					busy = true;
+					
+					break;
+				case STAGE_DECODED:
+					activate();
+					setStage(STAGE_SUCCEEDED);
+					
+					// Coarsest tile first, the fallback for every other
+					request(TILE_KEY(levels - 1,0,0),true);
+					
+					break;
+				default:
+					break;
+			}
+			
+			// Upload a bounded number of decoded tiles per frame
+			std::vector<struct decodedTile> ready;
+			
+			{
+				sf::Lock lock(streamMutex);
+				
+				unsigned int count = decoded.size() < TILE_UPLOADS_PER_FRAME ? decoded.size() : TILE_UPLOADS_PER_FRAME;
+				
+				ready.assign(decoded.begin(),decoded.begin() + count);
+				decoded.erase(decoded.begin(),decoded.begin() + count);
+				
+				// Failed tiles stay requested, so are never retried
+				for(std::vector<struct decodedTile>::iterator it = ready.begin();it != ready.end();++it){
+					if(it->generation == streamGeneration && it->image != NULL){
+						requested.erase(it->key);
+					}
+				}
+			}
+			
+			for(std::vector<struct decodedTile>::iterator it = ready.begin();it != ready.end();++it){
+				if(it->image != NULL){
+					if(loaded && it->generation == streamGeneration){
+						upload(*it);
+					}
+					
+					delete it->image;
+				}
+			}
+			
+			return streaming() || busy;
+		}
+		
+		bool streaming(){
+			sf::Lock lock(streamMutex);
+			return streamRunning || !decoded.empty();
 		}
 		
-		bool load(const char *source,bool uniformScale){
-			bool thisLoaded = texture.loadFromFile(std::string(source));
-			loaded = loaded || thisLoaded;
+		enum graphics::loadStatus status(unsigned int *percent){
+			sf::Lock lock(buildMutex);
+			*percent = 0;
 			
-			if(thisLoaded){
-				sprite.setColor(sf::Color(0xffffff80));
-				sprite.setTexture(texture,true);
-				sprite.setOrigin(sf::Vector2f(texture.getSize()) / 2.0f);
-				
-				sf::Vector2u size = texture.getSize();
-				
-				if(uniformScale){
-					float maxDim = (float)(size.x > size.y ? size.x : size.y);
-					sprite.setScale(2.0 / maxDim,2.0 / maxDim);
-				}else{
-					sprite.setScale(2.0 / (float)size.x,2.0 / (float)size.y);
-				}
+			switch(stage){
+				case STAGE_DECODING:
+				case STAGE_DECODED:
+					*percent = buildTotal == 0 ? 0 : (buildDone * 100) / buildTotal;
+					
+					return graphics::LOAD_BUSY;
+				case STAGE_SUCCEEDED:
+					stage = STAGE_IDLE;
+					*percent = 100;
+					
+					return graphics::LOAD_SUCCEEDED;
+				case STAGE_FAILED:
+					stage = STAGE_IDLE;
+					
+					return graphics::LOAD_FAILED;
+				default:
+					break;
 			}
 			
-			return thisLoaded;
+			return graphics::LOAD_IDLE;
 		}
 		
 		void unload(){
 			loaded = false;
+			sceneCacheValid = false;
+			
+			clearTiles();
+			
+			{
+				sf::Lock lock(streamMutex);
+				streamTiles.clear();
+			}
+			
+			// Drop any build in flight as well
+			sf::Lock lock(buildMutex);
+			
+			switch(stage){
+				case STAGE_DECODING:
+					buildCancelled = true;
+					
+					break;
+				case STAGE_DECODED:
+					stage = STAGE_IDLE;
+					
+					break;
+				default:
+					break;
+			}
 		}
 		
-		bool isLoaded(){
-			return loaded;
+		// Where the last loaded pyramid is cached, as a note for load feedback
+		const char *storeNote(){
+			switch(streamStore){
+				case TILE_STORE_TEMP:
+					return " (source directory unwritable, tiles cached in the temp directory)";
+				case TILE_STORE_MEMORY:
+					return " (source and temp directories unwritable, tiles kept in memory)";
+				default:
+					break;
+			}
+			
+			return "";
 		}
 		
 		void toggleSmooth(){
@@ -284,7 +1358,13 @@ class loadableTexture{
 				return;
 			}
 			
-			texture.setSmooth(!texture.isSmooth());
+			smooth = !smooth;
+			
+			for(std::list<struct tile>::iterator it = cache.begin();it != cache.end();++it){
+				it->texture.setSmooth(smooth);
+			}
+			
+			sceneCacheValid = false;
 		}
 		
 		void draw(){
@@ -292,21 +1372,172 @@ class loadableTexture{
 				return;
 			}
 			
-			target->draw(
-				sprite,
-				sf::RenderStates(
-					sf::Transform().translate(
-						vw::norm::transform().transformPoint(vw::norm::toD(0),vw::norm::toD(0))
-					).scale(
-						vw::norm::getZoomScale(),
-						vw::norm::getZoomScale()
-					)
-				)
-			);
+			hud::flush();
+			
+			// Screen pixels per image pixel, the image spanning the normalized square
+			float pixelScale = vw::norm::getZoomScale() * 2.0 / (float)(width > height ? width : height);
+			sf::Vector2f origin = vw::norm::transform().transformPoint(vw::norm::toD(0),vw::norm::toD(0));
+			
+			// Coarsest level whose texels are no larger than a screen pixel
+			unsigned int level = 0;
+			
+			while(level + 1 < levels && pixelScale * (float)(2 << level) <= 1.0){
+				++level;
+			}
+			
+			// Visible tile range, in image pixels
+			float span = (float)(TILE_SIZE << level);
+			
+			float left = (minX - origin.x) / pixelScale + width / 2.0f;
+			float right = (maxX - origin.x) / pixelScale + width / 2.0f;
+			float top = (minY - origin.y) / pixelScale + height / 2.0f;
+			float bottom = (maxY - origin.y) / pixelScale + height / 2.0f;
+			
+			if(right < 0.0 || bottom < 0.0 || left > width || top > height){
+				return;
+			}
+			
+			unsigned int levelWidth = ((width - 1) >> level) + 1;
+			unsigned int levelHeight = ((height - 1) >> level) + 1;
+			
+			unsigned int x0 = left < 0.0 ? 0 : (unsigned int)(left / span);
+			unsigned int y0 = top < 0.0 ? 0 : (unsigned int)(top / span);
+			unsigned int x1 = (unsigned int)(right / span);
+			unsigned int y1 = (unsigned int)(bottom / span);
+			
+			x1 = x1 >= tilesAcross(levelWidth) ? tilesAcross(levelWidth) - 1 : x1;
+			y1 = y1 >= tilesAcross(levelHeight) ? tilesAcross(levelHeight) - 1 : y1;
+			
+			// Drop requests for tiles no longer in view
+			{
+				sf::Lock lock(streamMutex);
+				
+				for(std::deque<uint64_t>::iterator it = requests.begin();it != requests.end();++it){
+					requested.erase(*it);
+				}
+				
+				requests.clear();
+			}
+			
+			request(TILE_KEY(levels - 1,0,0),true);
+			
+			for(unsigned int y = y0;y <= y1;++y){
+				for(unsigned int x = x0;x <= x1;++x){
+					if(cached(TILE_KEY(level,x,y)) == NULL){
+						request(TILE_KEY(level,x,y),false);
+					}
+					
+					drawRegion(level,x,y,origin,pixelScale);
+				}
+			}
+		}
+};
+
+// Retained HUD panel class
+#define PANEL_KEY_SEED 0xcbf29ce484222325ULL
+#define PANEL_KEY_PRIME 0x100000001b3ULL
+
+uint64_t panelKey(uint64_t key,const void *data,size_t len){
+	// FNV-1a over the panel's inputs
+	const unsigned char *bytes = (const unsigned char *)data;
+	
+	for(size_t i = 0;i < len;++i){
+		key = (key ^ bytes[i]) * PANEL_KEY_PRIME;
+	}
+	
+	return key;
+}
+
+uint64_t panelKey(uint64_t key,uint32_t val){
+	return panelKey(key,&val,sizeof(val));
+}
+
+uint64_t panelKey(uint64_t key,const char *str){
+	if(str == NULL){
+		return panelKey(key,(uint32_t)0xffffffff);
+	}
+	
+	return panelKey(key,str,strlen(str) + 1);
+}
+
+class hudPanel{
+	private:
+		sf::RenderTexture canvas;
+		sf::Sprite sprite;
+		
+		sf::RenderTarget *parent;
+		
+		uint64_t key;
+		bool valid;
+		
+		void drawCached(){
+			// Canvas colors are premultiplied by their coverage
+			target->draw(sprite,sf::RenderStates(sf::BlendMode(sf::BlendMode::One,sf::BlendMode::OneMinusSrcAlpha)));
 		}
 		
-		unsigned int glTex(){
-			return texture.getNativeHandle();
+	public:
+		hudPanel(){
+			parent = NULL;
+			
+			key = 0;
+			valid = false;
+		}
+		
+		// Draws the cached panel and returns false if its key is unchanged,
+		// otherwise redirects drawing into the panel until end() and returns true
+		bool begin(const sf::RectangleShape &back,uint64_t newKey){
+			float left = minX + floor(back.getPosition().x - LINE_WIDTH - minX);
+			float top = minY + floor(back.getPosition().y - LINE_WIDTH - minY);
+			unsigned int width = ceil(back.getSize().x + LINE_WIDTH * 2.0) + 1;
+			unsigned int height = ceil(back.getSize().y + LINE_WIDTH * 2.0) + 1;
+			
+			newKey = panelKey(newKey,&left,sizeof(left));
+			newKey = panelKey(newKey,&top,sizeof(top));
+			newKey = panelKey(newKey,width);
+			newKey = panelKey(newKey,height);
+			
+			if(valid && newKey == key){
+				drawCached();
+				
+				return false;
+			}
+			
+			if(canvas.getSize().x != width || canvas.getSize().y != height){
+				if(!canvas.create(width,height)){
+					// Fall back to drawing directly
+					valid = false;
+					
+					return true;
+				}
+				
+				sprite.setTexture(canvas.getTexture(),true);
+			}
+			
+			canvas.setView(sf::View(sf::FloatRect(left,top,width,height)));
+			canvas.clear(sf::Color::Transparent);
+			
+			sprite.setPosition(left,top);
+			
+			parent = target;
+			target = &canvas;
+			
+			key = newKey;
+			valid = true;
+			
+			return true;
+		}
+		
+		void end(){
+			if(parent == NULL){
+				return;
+			}
+			
+			canvas.display();
+			
+			target = parent;
+			parent = NULL;
+			
+			drawCached();
 		}
 };
 
@@ -344,8 +1575,14 @@ namespace graphics{
 			return false;
 		}
 		
+		unif::invalidate();
+		pose::reupload();
+		
 		target->setActive(false);
 		
+		// Grid shader, lines are drawn individually without it
+		gridShaderLoaded = sf::Shader::isAvailable() && gridShader.loadFromMemory(GRID_SHADER_FRAG,sf::Shader::Fragment);
+		
 		// Text
 		if(!hudFont.loadFromFile(hudFontPath)){
 			return false;
@@ -376,14 +1613,10 @@ namespace graphics{
 		
 		// Markers: shapes whose areas are same as a unit circle of radius 1
 		// Except for the triangle, which was artificially scaled by a factor to reduce apparant size
-		circle.setPointCount(64);
+		circle.setPointCount(CIRCLE_POINT_COUNT);
 		circle.setRadius(1.0);
 		circle.setOrigin(sf::Vector2f(1.0,1.0));
 		
-		circleOutline.setPointCount(64);
-		circleOutline.setFillColor(sf::Color(0x00000000));
-		circleOutline.setOutlineThickness(LINE_WIDTH);
-		
 		float triangleScalar = 5.0 / 6.0;
 		float triangleHalfHeight = triangleScalar * sqrt(sqrt(3) * PI) / 2.0;
 		float triangleHalfBase = triangleScalar * sqrt(PI / sqrt(3));
@@ -428,6 +1661,11 @@ namespace graphics{
 		wedge.setPoint(1,sf::Vector2f(1.0,1.0));
 		wedge.setPoint(2,sf::Vector2f(1.0,-1.0));
 		
+		// Batched circle points
+		for(unsigned int i = 0;i < CIRCLE_POINT_COUNT;++i){
+			unitCircle[i] = sf::Vector2f(cos(2.0 * PI * i / CIRCLE_POINT_COUNT),sin(2.0 * PI * i / CIRCLE_POINT_COUNT));
+		}
+		
 		// Help string dimensions
 		for(unsigned int i = 0;i < 4;++i){
 			helpGeneralDimensions[i] = calculateStringDimensions(mesherHelpGenerals[i].getString());
@@ -463,6 +1701,14 @@ namespace render{
 			return texTex.load(source,false);
 		}
 		
+		bool update(){
+			return texTex.update();
+		}
+		
+		enum graphics::loadStatus loadStatus(unsigned int *percent){
+			return texTex.status(percent);
+		}
+		
 		void unload(){
 			texTex.unload();
 		}
@@ -480,18 +1726,77 @@ namespace render{
 		}
 	}
 	
-	void applyColors(unsigned int pfl,enum clr::alpha alph,bool solid){
+	namespace scene{
+		void invalidate(){
+			sceneCacheValid = false;
+		}
+		
+		bool begin(){
+			sf::Vector2u size = target->getSize();
+			
+			if(!sceneCacheValid || sceneCache.getSize() != size){
+				return true;
+			}
+			
+			// Blit in window pixels, replacing whatever was cleared
+			sf::View view = target->getView();
+			
+			target->setView(sf::View(sf::FloatRect(0.0,0.0,size.x,size.y)));
+			target->draw(sceneCacheSprite,sf::RenderStates(sf::BlendNone));
+			target->setView(view);
+			
+			return false;
+		}
+		
+		void end(const sf::Window &window){
+			hud::flush();
+			
+			sf::Vector2u size = window.getSize();
+			
+			if(sceneCache.getSize() != size){
+				if(!sceneCache.create(size.x,size.y)){
+					sceneCacheValid = false;
+					
+					return;
+				}
+				
+				// Blitted rows run bottom-up, so the sprite flips them back
+				sceneCacheSprite.setTexture(sceneCache,true);
+				sceneCacheSprite.setTextureRect(sf::IntRect(0,size.y,size.x,-(int)size.y));
+			}
+			
+			// Blit the window in, resolving any multisampling
+			target->setActive(true);
+			
+			if(sceneCacheFbo == 0){
+				glGenFramebuffers(1,&sceneCacheFbo);
+			}
+			
+			glBindFramebuffer(GL_READ_FRAMEBUFFER,0);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER,sceneCacheFbo);
+			glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,sceneCache.getNativeHandle(),0);
+			
+			glBlitFramebuffer(0,0,size.x,size.y,0,0,size.x,size.y,GL_COLOR_BUFFER_BIT,GL_NEAREST);
+			
+			glBindFramebuffer(GL_FRAMEBUFFER,0);
+			target->setActive(false);
+			
+			sceneCacheValid = true;
+		}
+	}
+	
+	void applyColors(unsigned int pfl,unsigned char palette,enum clr::alpha alph){
 		switch(pfl){
 			case CLR_PFL_EDITOR:
-				clr::apply(clr::PFL_WHITE,CLR_WHITE_WHITE,alph,solid ? clr::PFL_EDITR_SOL : clr::PFL_EDITR);
+				clr::apply(clr::PFL_WHITE,CLR_WHITE_WHITE,alph,clr::PFL_EDITR);
 				
 				break;
 			case CLR_PFL_RANBW:
-				clr::apply(clr::PFL_WHITE,CLR_WHITE_WHITE,alph,solid ? clr::PFL_RANBW_SOL : clr::PFL_RANBW);
+				clr::apply(clr::PFL_WHITE,CLR_WHITE_WHITE,alph,clr::PFL_RANBW);
 				
 				break;
 			case CLR_PFL_CSTM:
-				clrCstm::apply(clr::PFL_WHITE,CLR_WHITE_WHITE,alph);
+				clrCstm::apply(palette,clr::PFL_WHITE,CLR_WHITE_WHITE,alph);
 				
 				break;
 			default:
@@ -499,7 +1804,9 @@ namespace render{
 		}
 	}
 	
-	void loadAndDrawTris(struct vecTrisBuf *buf,struct vecTris **tris,unsigned int vert,unsigned int frag,unsigned int pfl,bool wireframe){
+	void loadAndDrawTris(struct vecTrisBuf *buf,struct vecTris **tris,unsigned int vert,unsigned int frag,unsigned int pfl,unsigned char palette,bool wireframe,float offsetX,float offsetY){
+		hud::flush();
+		
 		target->setActive(true);
 		resetBindings();
 		
@@ -513,7 +1820,7 @@ namespace render{
 		if(*tris != NULL){
 			// Initilization
 			useShader();
-			vw::norm::vecGL::apply(*target,0.0,0.0,1.0,1.0);
+			vw::norm::vecGL::apply(*target,offsetX,offsetY,1.0,1.0);
 			
 			if(vert == VERT_MODE_POSE_XY){
 				pose::upload();
@@ -524,27 +1831,26 @@ namespace render{
 			}
 			
 			// Sub-cases
+			applyColors(pfl,palette,clr::ALF_ONE);
+			
 			if(wireframe){
-				// Fill
-				applyColors(pfl,clr::ALF_HALF,false);
-				uniformVertFragModes(vert,frag);
-				drawVecTris(*tris);
-				
-				// Outline
-				glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
-				glLineWidth(LINE_WIDTH);
-				glEnable(GL_LINE_SMOOTH);
-				
-				applyColors(pfl,clr::ALF_ONE,true);
-				uniformVertFragModes(vert,FRAG_MODE_FULL_CLR);
-				drawVecTris(*tris);
-				
-				glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
+				// Fill and outline in a single pass, sampled as the fill would be
+				unif::vertFragModes(vert,frag == FRAG_MODE_CLIPPED_CLR_SMPL ? FRAG_MODE_WIRE_CLR_SMPL : FRAG_MODE_WIRE_CLR);
+			}else if(frag == FRAG_MODE_CLIPPED_CLR || frag == FRAG_MODE_CLIPPED_CLR_SMPL){
+				// Normal drawing, clipped by coverage rather than fragClip()
+				unif::vertFragModes(vert,frag == FRAG_MODE_CLIPPED_CLR_SMPL ? FRAG_MODE_COVERED_CLR_SMPL : FRAG_MODE_COVERED_CLR);
 			}else{
-				// Normal drawing
-				applyColors(pfl,clr::ALF_ONE,false);
-				uniformVertFragModes(vert,frag);
-				drawVecTris(*tris);
+				unif::vertFragModes(vert,frag);
+			}
+			
+			for(unsigned int i = 0;i < SHADER_BARY_CLIP_COUNT;++i){
+				glEnable(GL_CLIP_DISTANCE0 + i);
+			}
+			
+			drawVecTris(*tris);
+			
+			for(unsigned int i = 0;i < SHADER_BARY_CLIP_COUNT;++i){
+				glDisable(GL_CLIP_DISTANCE0 + i);
 			}
 		}
 		
@@ -595,14 +1901,98 @@ namespace hud{
 		return (enum markType)((i / CLR_RANBW_NULL) % MARK_COUNT);
 	}
 	
+	// Batching ----------------------------------------------------------------------------------------------------------------------------------------------------
+	void batchTri(sf::Vector2f a,sf::Vector2f b,sf::Vector2f c,sf::Color color){
+		primBatch.push_back(sf::Vertex(a,color));
+		primBatch.push_back(sf::Vertex(b,color));
+		primBatch.push_back(sf::Vertex(c,color));
+	}
+	
+	void batchShape(const sf::Shape &shape,const sf::Transform &transform,uint32_t color){
+		// Convex shapes only, fanned out from the first point
+		sf::Transform combined = transform * shape.getTransform();
+		sf::Color batchColor(color);
+		
+		sf::Vector2f first = combined.transformPoint(shape.getPoint(0));
+		sf::Vector2f prev = combined.transformPoint(shape.getPoint(1));
+		sf::Vector2f curr;
+		
+		for(size_t i = 2;i < shape.getPointCount();++i){
+			curr = combined.transformPoint(shape.getPoint(i));
+			batchTri(first,prev,curr,batchColor);
+			
+			prev = curr;
+		}
+	}
+	
+	unsigned int batchCircleStride(float radius){
+		// Small circles need far fewer than the full point count
+		if(radius < 16.0){
+			return 4;
+		}else if(radius < 48.0){
+			return 2;
+		}
+		
+		return 1;
+	}
+	
+	void batchCircle(sf::Vector2f center,float radius,uint32_t color){
+		sf::Color batchColor(color);
+		unsigned int stride = batchCircleStride(radius);
+		
+		for(unsigned int i = 0;i < CIRCLE_POINT_COUNT;i += stride){
+			batchTri(
+				center,
+				center + unitCircle[i] * radius,
+				center + unitCircle[(i + stride) % CIRCLE_POINT_COUNT] * radius,
+				batchColor
+			);
+		}
+	}
+	
+	void batchRing(sf::Vector2f center,float radius,float thickness,uint32_t color){
+		sf::Color batchColor(color);
+		unsigned int stride = batchCircleStride(radius + thickness);
+		
+		sf::Vector2f a,b;
+		
+		for(unsigned int i = 0;i < CIRCLE_POINT_COUNT;i += stride){
+			a = unitCircle[i];
+			b = unitCircle[(i + stride) % CIRCLE_POINT_COUNT];
+			
+			batchTri(center + a * radius,center + a * (radius + thickness),center + b * (radius + thickness),batchColor);
+			batchTri(center + a * radius,center + b * (radius + thickness),center + b * radius,batchColor);
+		}
+	}
+	
+	void flush(){
+		if(primBatch.empty()){
+			return;
+		}
+		
+		target->draw(&primBatch[0],primBatch.size(),sf::Triangles);
+		primBatch.clear();
+	}
+	
+	// Panels ----------------------------------------------------------------------------------------------------------------------------------------------------
+	class hudPanel stateStatePanel,helpPanel,bottomBarPanel,layerNavPanel;
+	class hudPanel customColorsRefPanel,vBonesRefPanel,bonesRefPanel;
+	
 	// Drawing ----------------------------------------------------------------------------------------------------------------------------------------------------
 	void drawCenter(){
-		target->draw(center,sf::RenderStates(sf::Transform().translate(vw::transform().transformPoint(0.0,0.0))));
+		batchShape(center,sf::Transform().translate(vw::transform().transformPoint(0.0,0.0)),0xffffffff);
 	}
 	
 	void drawStateState(enum mesherState state){
+		flush();
+		
 		hudBack.setSize(sf::Vector2f((2.0 + STATE_TITLE_MAX_LEN + STATE_COUNT * STATE_SYMBOL_UNIT_WIDTH) * charWidth,charHeight * 2.0));
 		hudBack.setPosition(charPosition(cTL,0.0,0.0));
+		
+		if(!stateStatePanel.begin(hudBack,panelKey(PANEL_KEY_SEED,state))){
+			return;
+		}
+		
 		target->draw(hudBack);
 		
 		if(state < STATE_COUNT){
@@ -628,9 +2018,13 @@ namespace hud{
 			mesherStateTitles[state].setFillColor(sf::Color(0xffffffff));
 			target->draw(mesherStateTitles[state]);
 		}
+		
+		stateStatePanel.end();
 	}
 	
 	void drawHelp(enum mesherState state){
+		flush();
+		
 		// Brief state indexation
 		int isTextual = state::isTextual(state);
 		int isAtop = (state >= STATE_COUNT);
@@ -649,6 +2043,11 @@ namespace hud{
 		
 		hudBack.setSize(sf::Vector2f((4.0 + backgroundDimensions.x) * charWidth,(2.5 + backgroundDimensions.y + 2.5 + 1.5) * charHeight));
 		hudBack.setPosition(charPosition(cTL,0.0,2.0) + sf::Vector2f(0.0,2.0));
+		
+		if(!helpPanel.begin(hudBack,panelKey(PANEL_KEY_SEED,state))){
+			return;
+		}
+		
 		target->draw(hudBack);
 		
 		// Text -------------
@@ -663,26 +2062,38 @@ namespace hud{
 		mesherHelpGenerals[sI].setPosition(charPosition(cTL,2.0,4.5));
 		target->draw(mesherHelpGenerals[sI]);
 		
-		if(state >= STATE_COUNT){
-			return;
+		if(state < STATE_COUNT){
+			// State help title
+			mesherHelpTitleUnderline.setPosition(charPosition(cTL,2.0,4.5 + helpGeneralDimensions[sI].y + 1.0));
+			target->draw(mesherHelpTitleUnderline);
+			
+			mesherStateTitles[state].setPosition(charPosition(cTL,2.0,4.5 + helpGeneralDimensions[sI].y + 1.0));
+			target->draw(mesherStateTitles[state]);
+			
+			// State help content
+			mesherHelpStates[state].setPosition(charPosition(cTL,2.0,4.5 + helpGeneralDimensions[sI].y + 2.5));
+			target->draw(mesherHelpStates[state]);
 		}
 		
-		// State help title
-		mesherHelpTitleUnderline.setPosition(charPosition(cTL,2.0,4.5 + helpGeneralDimensions[sI].y + 1.0));
-		target->draw(mesherHelpTitleUnderline);
-		
-		mesherStateTitles[state].setPosition(charPosition(cTL,2.0,4.5 + helpGeneralDimensions[sI].y + 1.0));
-		target->draw(mesherStateTitles[state]);
-		
-		// State help content
-		mesherHelpStates[state].setPosition(charPosition(cTL,2.0,4.5 + helpGeneralDimensions[sI].y + 2.5));
-		target->draw(mesherHelpStates[state]);
+		helpPanel.end();
 	}
 	
 	void drawBottomBar(const char *line,bool snapOn,bool showTris,unsigned char currTri){
+		flush();
+		
 		// Background
 		hudBack.setSize(sf::Vector2f(viewWidth,charHeight * 3.0));
 		hudBack.setPosition(charPosition(cBL,0.0,2.0));
+		
+		uint64_t key = panelKey(PANEL_KEY_SEED,line);
+		key = panelKey(key,snapOn);
+		key = panelKey(key,showTris);
+		key = panelKey(key,currTri);
+		
+		if(!bottomBarPanel.begin(hudBack,key)){
+			return;
+		}
+		
 		target->draw(hudBack);
 		
 		// Text
@@ -717,11 +2128,31 @@ namespace hud{
 				target->draw(hudTextTris[i]);
 			}
 		}
+		
+		bottomBarPanel.end();
 	}
 	
 	void drawLayerNav(std::vector<class vertLayer *> &layers,unsigned int currLayer,const char *altCurrLayerName,class gridLayer *grid,const char *altGridDisplay){
+		flush();
+		
 		hudBack.setPosition(charPosition(cTR,6.0 + LAYER_NAME_STRLEN,-0.5));
 		hudBack.setSize(sf::Vector2f((7.0 + LAYER_NAME_STRLEN) * charWidth,(layers.size() + 5.0) * charHeight));
+		
+		uint64_t key = panelKey(PANEL_KEY_SEED,currLayer);
+		key = panelKey(key,altCurrLayerName);
+		key = panelKey(key,grid->get());
+		key = panelKey(key,grid->visible());
+		key = panelKey(key,altGridDisplay);
+		
+		for(std::vector<class vertLayer *>::iterator it = layers.begin();it != layers.end();++it){
+			key = panelKey(key,(*it)->nameGet());
+			key = panelKey(key,(*it)->visible());
+		}
+		
+		if(!layerNavPanel.begin(hudBack,key)){
+			return;
+		}
+		
 		target->draw(hudBack);
 		
 		if(currLayer < layers.size()){
@@ -783,9 +2214,11 @@ namespace hud{
 		}
 		
 		target->draw(hudTextGridDisplay);
+		
+		layerNavPanel.end();
 	}
 	
-	void drawCustomColorsRef(unsigned char currColor,const char *altCurrColorHex){
+	void drawCustomColorsRef(unsigned char palette,unsigned char currColor,const char *altCurrColorHex){
 		#define COLREF_CHLPAD 1
 		#define COLREF_CHRPAD 2
 		#define COLREF_CVPAD 1.5
@@ -803,9 +2236,23 @@ namespace hud{
 		#define COLREF_ICX(i) (COLREF_CWIDTH - COLREF_CHLPAD - (COLREF_ICWIDTH * ((i / COLREF_IHEIGHT) + 1)))
 		#define COLREF_ICY(i) (COLREF_CTOP - COLREF_CVPAD - (i % COLREF_IHEIGHT))
 		
+		flush();
+		
 		// Background
 		hudBack.setPosition(charPosition(cBR,COLREF_CWIDTH,COLREF_CTOP));
 		hudBack.setSize(sf::Vector2f(COLREF_CWIDTH * charWidth,COLREF_CHEIGHT * charHeight));
+		
+		uint64_t key = panelKey(PANEL_KEY_SEED,currColor);
+		key = panelKey(key,altCurrColorHex);
+		
+		for(unsigned int i = 0;i < COLOR_ARRAY_MAX_COUNT;++i){
+			key = panelKey(key,clrCstm::get(palette,i));
+		}
+		
+		if(!customColorsRefPanel.begin(hudBack,key)){
+			return;
+		}
+		
 		target->draw(hudBack);
 		
 		// Items
@@ -820,7 +2267,7 @@ namespace hud{
 			// Custom Color Background
 			colorBack.setPosition(charPosition(cBR,COLREF_ICX(i) + 10.5,COLREF_ICY(i)));
 			colorBack.setSize(sf::Vector2f(10.5 * charWidth,charHeight));
-			colorBack.setFillColor(sf::Color((clrCstm::get(i) & 0xffffff00) | clr::getAlpha(clr::ALF_HALF)));
+			colorBack.setFillColor(sf::Color((clrCstm::get(palette,i) & 0xffffff00) | clr::getAlpha(clr::ALF_HALF)));
 			target->draw(colorBack);
 			
 			// Current Color Highlight
@@ -836,7 +2283,7 @@ namespace hud{
 				if(altCurrColorHex != NULL){
 					sprintf(textBuffer,"%.9s",altCurrColorHex);
 				}else{
-					sprintf(textBuffer,"%08x",clrCstm::get(i));
+					sprintf(textBuffer,"%08x",clrCstm::get(palette,i));
 				}
 				
 				HUD_TEXT_INIT(hudTextColorHex,std::string(textBuffer));
@@ -851,7 +2298,7 @@ namespace hud{
 				target->draw(hudTextColorID);
 				
 			}else{
-				sprintf(textBuffer,"%2d   %08x",i,clrCstm::get(i));
+				sprintf(textBuffer,"%2d   %08x",i,clrCstm::get(palette,i));
 				
 				HUD_TEXT_INIT(hudTextColorHexID,std::string(textBuffer));
 				hudTextColorHexID.setPosition(charPosition(cBR,COLREF_ICX(i) + 14,COLREF_ICY(i)));
@@ -863,6 +2310,8 @@ namespace hud{
 			drawn->setFillColor(sf::Color(markColor(i,clr::ALF_ONE)));
 			target->draw(*drawn,sf::RenderStates(sf::Transform().translate(charPosition(cBR,COLREF_ICX(i) + 10.5,COLREF_ICY(i) - 0.5))));
 		}
+		
+		customColorsRefPanel.end();
 	}
 	
 	void drawVBonesRef(unsigned char currBone){
@@ -883,9 +2332,16 @@ namespace hud{
 		#define VBNEREF_ICX(i) (VBNEREF_CWIDTH - VBNEREF_CHLPAD - (VBNEREF_ICWIDTH * ((i / VBNEREF_IHEIGHT) + 1)))
 		#define VBNEREF_ICY(i) (VBNEREF_CTOP - VBNEREF_CVPAD - (i % VBNEREF_IHEIGHT))
 		
+		flush();
+		
 		// Background
 		hudBack.setPosition(charPosition(cBR,VBNEREF_CWIDTH,VBNEREF_CTOP));
 		hudBack.setSize(sf::Vector2f(VBNEREF_CWIDTH * charWidth,VBNEREF_CHEIGHT * charHeight));
+		
+		if(!vBonesRefPanel.begin(hudBack,panelKey(PANEL_KEY_SEED,currBone))){
+			return;
+		}
+		
 		target->draw(hudBack);
 		
 		// Items
@@ -918,6 +2374,8 @@ namespace hud{
 			drawn->setFillColor(sf::Color(markColor(i,clr::ALF_ONE)));
 			target->draw(*drawn,sf::RenderStates(sf::Transform().translate(charPosition(cBR,VBNEREF_ICX(i) + 1.5,VBNEREF_ICY(i) - 0.5))));
 		}
+		
+		vBonesRefPanel.end();
 	}
 	
 	void drawBonesRef(unsigned char currBone,const char *altCurrBoneParent){
@@ -938,9 +2396,23 @@ namespace hud{
 		#define BNEREF_ICX(i) (BNEREF_CWIDTH - BNEREF_CHLPAD - (BNEREF_ICWIDTH * ((i / BNEREF_IHEIGHT) + 1)))
 		#define BNEREF_ICY(i) (BNEREF_CTOP - BNEREF_CVPAD - (i % BNEREF_IHEIGHT))
 		
+		flush();
+		
 		// Background
 		hudBack.setPosition(charPosition(cBR,BNEREF_CWIDTH,BNEREF_CTOP));
 		hudBack.setSize(sf::Vector2f(BNEREF_CWIDTH * charWidth,BNEREF_CHEIGHT * charHeight));
+		
+		uint64_t key = panelKey(PANEL_KEY_SEED,currBone);
+		key = panelKey(key,altCurrBoneParent);
+		
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			key = panelKey(key,bones::getParent(i));
+		}
+		
+		if(!bonesRefPanel.begin(hudBack,key)){
+			return;
+		}
+		
 		target->draw(hudBack);
 		
 		// Items
@@ -988,31 +2460,20 @@ namespace hud{
 			drawn->setFillColor(sf::Color(markColor(i,clr::ALF_ONE)));
 			target->draw(*drawn,sf::RenderStates(sf::Transform().translate(charPosition(cBR,BNEREF_ICX(i) + 5.5,BNEREF_ICY(i) - 0.5))));
 		}
+		
+		bonesRefPanel.end();
 	}
 	
 	void drawCircle(int32_t x,int32_t y,bool isRadNorm,float radius,uint32_t color){
 		float newRadius = isRadNorm ? vw::norm::getScale() * radius : radius;
 		
-		circle.setScale(newRadius,newRadius);
-		circle.setFillColor(sf::Color(color));
-		
-		target->draw(
-			circle,
-			sf::RenderStates(sf::Transform().translate(vw::norm::transform().transformPoint(vw::norm::toD_u(x),vw::norm::toD_u(y))))
-		);
+		batchCircle(vw::norm::transform().transformPoint(vw::norm::toD_u(x),vw::norm::toD_u(y)),newRadius,color);
 	}
 	
 	void drawCircleOutline(int32_t x,int32_t y,bool isRadNorm,float radius,uint32_t color){
 		float newRadius = isRadNorm ? vw::norm::getScale() * radius : radius;
 		
-		circleOutline.setRadius(newRadius);
-		circleOutline.setOrigin(sf::Vector2f(newRadius,newRadius));
-		circleOutline.setOutlineColor(sf::Color(color));
-		
-		target->draw(
-			circleOutline,
-			sf::RenderStates(sf::Transform().translate(vw::norm::transform().transformPoint(vw::norm::toD_u(x),vw::norm::toD_u(y))))
-		);
+		batchRing(vw::norm::transform().transformPoint(vw::norm::toD_u(x),vw::norm::toD_u(y)),newRadius,LINE_WIDTH,color);
 	}
 	
 	void drawWedge(int32_t srcX,int32_t srcY,int32_t aX,int32_t aY,int32_t bX,int32_t bY,float radius,uint32_t color){
@@ -1045,25 +2506,24 @@ namespace hud{
 		// Drawing triangle
 		wedge.setScale(a,b);
 		wedge.setRotation(delta * 180.0 / PI);
-		wedge.setFillColor(sf::Color(color));
 		
-		target->draw(
-			wedge,
-			sf::RenderStates(sf::Transform().translate(vw::norm::transform().transformPoint(vw::norm::toD_u(srcX),vw::norm::toD_u(srcY))))
-		);
+		batchShape(wedge,sf::Transform().translate(vw::norm::transform().transformPoint(vw::norm::toD_u(srcX),vw::norm::toD_u(srcY))),color);
 	}
 	
 	void drawMark(unsigned int i,int32_t x,int32_t y,bool isScaleNorm,float scale){
 		float newScale = isScaleNorm ? vw::norm::getScale() * scale : scale;
-		sf::Shape *drawn = marks[markShape(i)];
+		sf::Vector2f center = vw::norm::transform().transformPoint(vw::norm::toD_u(x),vw::norm::toD_u(y));
+		
+		if(markShape(i) == MARK_CIRCLE){
+			batchCircle(center,newScale,markColor(i,clr::ALF_ONE));
+			
+			return;
+		}
 		
+		sf::Shape *drawn = marks[markShape(i)];
 		drawn->setScale(newScale,newScale);
-		drawn->setFillColor(sf::Color(markColor(i,clr::ALF_ONE)));
 		
-		target->draw(
-			*drawn,
-			sf::RenderStates(sf::Transform().translate(vw::norm::transform().transformPoint(vw::norm::toD_u(x),vw::norm::toD_u(y))))
-		);
+		batchShape(*drawn,sf::Transform().translate(center),markColor(i,clr::ALF_ONE));
 	}
 	
 	void drawStem(unsigned int i,int32_t srcX,int32_t srcY,int32_t destX,int32_t destY){
@@ -1077,12 +2537,8 @@ namespace hud{
 		
 		stem.setRotation(angle * 180.0 / PI);
 		stem.setScale(len,1.0);
-		stem.setFillColor(sf::Color(markColor(i,clr::ALF_HALF)));
 		
-		target->draw(
-			stem,
-			sf::RenderStates(sf::Transform().translate(vw::norm::transform().transformPoint(srcX_D,srcY_D)))
-		);
+		batchShape(stem,sf::Transform().translate(vw::norm::transform().transformPoint(srcX_D,srcY_D)),markColor(i,clr::ALF_HALF));
 	}
 	
 	void drawLine(enum lineType type,int16_t x,int16_t y,float len,uint32_t color){
@@ -1101,19 +2557,65 @@ namespace hud{
 				break;
 		}
 		
-		rect->setFillColor(sf::Color(color));
+		batchShape(*rect,sf::Transform().translate(vw::norm::transform().transformPoint(vw::norm::toD(x),vw::norm::toD(y))),color);
+	}
+	
+	void drawGrid(unsigned int divisions,uint32_t color){
+		double unit = 2.0 / ((double)divisions + 1.0);
+		
+		if(!gridShaderLoaded){
+			for(unsigned int i = 0;i < divisions + 2;++i){
+				drawLine(LINE_VERTICAL,vw::norm::toI(-1.0 + unit * (double)i),0,vw::norm::getZoomScale(),color);
+				drawLine(LINE_HORIZONTAL,0,vw::norm::toI(-1.0 + unit * (double)i),vw::norm::getZoomScale(),color);
+			}
+			
+			return;
+		}
+		
+		flush();
+		
+		// One quad over the normalized square, padded to fit the outer lines
+		float count = divisions + 1;
+		float pad = (LINE_WIDTH / 2.0 + 1.0) / vw::norm::getZoomScale();
+		float lo = -1.0 - pad;
+		float hi = 1.0 + pad;
+		
+		sf::Transform transform = vw::norm::transform();
+		sf::Vertex quad[4];
+		
+		quad[0] = sf::Vertex(transform.transformPoint(lo,lo),sf::Vector2f(-pad / unit,-pad / unit));
+		quad[1] = sf::Vertex(transform.transformPoint(hi,lo),sf::Vector2f(count + pad / unit,-pad / unit));
+		quad[2] = sf::Vertex(transform.transformPoint(hi,hi),sf::Vector2f(count + pad / unit,count + pad / unit));
+		quad[3] = sf::Vertex(transform.transformPoint(lo,hi),sf::Vector2f(-pad / unit,count + pad / unit));
+		
+		gridShader.setUniform("count",count);
+		gridShader.setUniform("lineWidth",(float)LINE_WIDTH);
+		gridShader.setUniform("color",sf::Glsl::Vec4(sf::Color(color)));
 		
-		target->draw(
-			*rect,
-			sf::RenderStates(sf::Transform().translate(vw::norm::transform().transformPoint(vw::norm::toD(x),vw::norm::toD(y))))
-		);
+		target->draw(quad,4,sf::Quads,sf::RenderStates(&gridShader));
 	}
 	
 	namespace ref{
-		class loadableTexture refTex;
+		class tiledImage refTex;
 		
 		bool load(const char *source){
-			return refTex.load(source,true);
+			return refTex.load(source);
+		}
+		
+		bool update(){
+			return refTex.update();
+		}
+		
+		bool streaming(){
+			return refTex.streaming();
+		}
+		
+		enum graphics::loadStatus loadStatus(unsigned int *percent){
+			return refTex.status(percent);
+		}
+		
+		const char *storeNote(){
+			return refTex.storeNote();
 		}
 		
 		void unload(){
@@ -0,0 +1,219 @@
+#include <deque>
+
+#include "history.hpp"
+#include "layer.hpp"
+
+struct histStep{
+	std::vector<struct histRecord> records;
+	size_t bytes;
+};
+
+namespace hist{
+	std::vector<struct histRecord> pending;
+	
+	std::deque<struct histStep> done;
+	std::deque<struct histStep> undone;
+	
+	size_t budgetBytes = HIST_DEFAULT_BUDGET_BYTES;
+	size_t usedBytes = 0;
+	
+	size_t recordBytes(const struct histRecord &rec){
+		return sizeof(rec) +
+			rec.indices.capacity() * sizeof(uint32_t) +
+			rec.values.capacity() * sizeof(uint16_t) +
+			rec.bits.capacity() * sizeof(uint64_t);
+	}
+	
+	void stepMeasure(struct histStep &step){
+		size_t bytes = sizeof(step);
+		
+		for(std::vector<struct histRecord>::const_iterator it = step.records.begin();it != step.records.end();++it){
+			bytes += recordBytes(*it);
+		}
+		
+		usedBytes = usedBytes - step.bytes + bytes;
+		step.bytes = bytes;
+	}
+	
+	// Oldest steps go first, then the deepest undone ones, though the latest step either way is always kept
+	void evict(){
+		while(usedBytes > budgetBytes && done.size() + undone.size() > 1){
+			if(done.size() > 1 || undone.empty()){
+				usedBytes -= done.front().bytes;
+				done.pop_front();
+			}else{
+				usedBytes -= undone.front().bytes;
+				undone.pop_front();
+			}
+		}
+	}
+	
+	// Recording ---------------------------------------------------
+	void record(struct histRecord &rec){
+		pending.push_back(histRecord());
+		
+		struct histRecord &stored = pending.back();
+		
+		stored.target = rec.target;
+		stored.op = rec.op;
+		stored.index = rec.index;
+		stored.count = rec.count;
+		
+		stored.indices.swap(rec.indices);
+		stored.values.swap(rec.values);
+		stored.bits.swap(rec.bits);
+	}
+	
+	void commit(){
+		if(pending.empty()){
+			return;
+		}
+		
+		// A new change makes the undone steps unreachable
+		for(std::deque<struct histStep>::iterator it = undone.begin();it != undone.end();++it){
+			usedBytes -= it->bytes;
+		}
+		
+		undone.clear();
+		
+		// Recorded step
+		done.push_back(histStep());
+		done.back().records.swap(pending);
+		done.back().bytes = 0;
+		
+		stepMeasure(done.back());
+		evict();
+	}
+	
+	// Traversal ---------------------------------------------------
+	bool undo(){
+		commit();
+		
+		if(done.empty()){
+			return false;
+		}
+		
+		undone.push_back(histStep());
+		undone.back().records.swap(done.back().records);
+		undone.back().bytes = done.back().bytes;
+		done.pop_back();
+		
+		// Latest change first
+		struct histStep &step = undone.back();
+		
+		for(std::vector<struct histRecord>::reverse_iterator it = step.records.rbegin();it != step.records.rend();++it){
+			it->target->hist_Apply(*it,true);
+		}
+		
+		// Undone appends hold on to their triangles
+		stepMeasure(step);
+		evict();
+		
+		return true;
+	}
+	
+	bool redo(){
+		commit();
+		
+		if(undone.empty()){
+			return false;
+		}
+		
+		done.push_back(histStep());
+		done.back().records.swap(undone.back().records);
+		done.back().bytes = undone.back().bytes;
+		undone.pop_back();
+		
+		// Earliest change first
+		struct histStep &step = done.back();
+		
+		for(std::vector<struct histRecord>::iterator it = step.records.begin();it != step.records.end();++it){
+			it->target->hist_Apply(*it,false);
+		}
+		
+		stepMeasure(step);
+		evict();
+		
+		return true;
+	}
+	
+	// Budget ---------------------------------------------------
+	void budgetSet(size_t bytes){
+		budgetBytes = bytes;
+		evict();
+	}
+	
+	size_t budget(){
+		return budgetBytes;
+	}
+	
+	size_t used(){
+		return usedBytes;
+	}
+	
+	bool budgetMet(){
+		return usedBytes <= budgetBytes;
+	}
+	
+	unsigned int undoable(){
+		return done.size() + !pending.empty();
+	}
+	
+	unsigned int redoable(){
+		return undone.size();
+	}
+	
+	// Layer deletion ---------------------------------------------------
+	void forgetIn(std::vector<struct histRecord> &records,class vertLayer *target){
+		std::vector<struct histRecord>::iterator kept = records.begin();
+		
+		for(std::vector<struct histRecord>::iterator it = records.begin();it != records.end();++it){
+			if(it->target == target){
+				continue;
+			}
+			
+			if(kept != it){
+				kept->target = it->target;
+				kept->op = it->op;
+				kept->index = it->index;
+				kept->count = it->count;
+				
+				kept->indices.swap(it->indices);
+				kept->values.swap(it->values);
+				kept->bits.swap(it->bits);
+			}
+			
+			++kept;
+		}
+		
+		records.erase(kept,records.end());
+	}
+	
+	void forget(class vertLayer *target){
+		forgetIn(pending,target);
+		
+		for(std::deque<struct histStep>::iterator it = done.begin();it != done.end();){
+			forgetIn(it->records,target);
+			stepMeasure(*it);
+			
+			if(it->records.empty()){
+				usedBytes -= it->bytes;
+				it = done.erase(it);
+			}else{
+				++it;
+			}
+		}
+		
+		for(std::deque<struct histStep>::iterator it = undone.begin();it != undone.end();){
+			forgetIn(it->records,target);
+			stepMeasure(*it);
+			
+			if(it->records.empty()){
+				usedBytes -= it->bytes;
+				it = undone.erase(it);
+			}else{
+				++it;
+			}
+		}
+	}
+}
@@ -0,0 +1,183 @@
+#include <cmath>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+extern "C" {
+	#include <vecGL/bones.h>
+}
+
+#include "inverseKinematics.hpp"
+#include "skeleton.hpp"
+
+#define PI 3.14159265358979323846
+
+// Distance to target, in normalized units, considered reached
+#define IK_TOLERANCE 16
+
+// Sweep rotation, in degrees, below which an unreachable target is considered settled
+#define IK_SETTLE_DEGREES 0.01
+
+struct chainJoint{
+	unsigned char bone;
+	
+	// Local pose at the start, restored upon cancel
+	int32_t translateX,translateY;
+	float scale,rotation;
+};
+
+namespace ik{
+	unsigned char end = BONES_MAX_COUNT;
+	std::vector<struct chainJoint> chain;
+	
+	int32_t targetX,targetY;
+	bool settled = true;
+	
+	// Position within the chain the last solve stopped at
+	unsigned int nextJoint = 0;
+	float sweepRotation = 0.0;
+	
+	sf::Clock budgetClock;
+	
+	bool begin(unsigned char endBone){
+		end = endBone % BONES_MAX_COUNT;
+		chain.clear();
+		
+		// The end bone pivots about its own position, leaving only its ancestors to move it
+		for(unsigned char i = bones::getParent(end);i < BONES_MAX_COUNT;i = bones::getParent(i)){
+			struct chainJoint joint;
+			
+			joint.bone = i;
+			pose::getLocal(i,&joint.translateX,&joint.translateY,&joint.scale,&joint.rotation);
+			
+			chain.push_back(joint);
+		}
+		
+		if(chain.empty()){
+			end = BONES_MAX_COUNT;
+			return false;
+		}
+		
+		sf::Vector2<int32_t> endPos = pose::getBonePosition(end);
+		
+		targetX = endPos.x;
+		targetY = endPos.y;
+		settled = true;
+		
+		return true;
+	}
+	
+	void target(int32_t x,int32_t y){
+		if(end >= BONES_MAX_COUNT || (x == targetX && y == targetY)){
+			return;
+		}
+		
+		targetX = x;
+		targetY = y;
+		
+		// Warm start: the chain keeps its current rotations
+		settled = false;
+		nextJoint = 0;
+		sweepRotation = 0.0;
+	}
+	
+	bool reached(){
+		sf::Vector2<int32_t> endPos = pose::getBonePosition(end);
+		
+		double dX = (double)targetX - endPos.x;
+		double dY = (double)targetY - endPos.y;
+		
+		return dX * dX + dY * dY <= (double)IK_TOLERANCE * IK_TOLERANCE;
+	}
+	
+	// Cyclic coordinate descent, one joint at a time from the end bone's parent outwards,
+	// until reached, settled, or out of the frame's budget
+	bool solve(){
+		if(settled){
+			return false;
+		}
+		
+		budgetClock.restart();
+		bool changed = false;
+		
+		while(budgetClock.getElapsedTime().asMicroseconds() < IK_BUDGET_MICROSECONDS){
+			if(nextJoint == 0){
+				if(reached()){
+					settled = true;
+					break;
+				}
+			}
+			
+			struct chainJoint &joint = chain[nextJoint];
+			
+			sf::Vector2<int32_t> pivot = pose::getBonePosition(joint.bone);
+			sf::Vector2<int32_t> endPos = pose::getBonePosition(end);
+			
+			double toEnd = atan2((double)endPos.y - pivot.y,(double)endPos.x - pivot.x);
+			double toTarget = atan2((double)targetY - pivot.y,(double)targetX - pivot.x);
+			double delta = (toTarget - toEnd) * 180.0 / PI;
+			
+			if(delta > 180.0){
+				delta -= 360.0;
+			}else if(delta < -180.0){
+				delta += 360.0;
+			}
+			
+			if(endPos != pivot && fabs(delta) > 0.0){
+				int32_t tX,tY;
+				float scale,rotation;
+				
+				pose::getLocal(joint.bone,&tX,&tY,&scale,&rotation);
+				pose::setLocal(joint.bone,tX,tY,scale,rotation + (float)delta);
+				pose::update();
+				
+				sweepRotation += fabs(delta);
+				changed = true;
+			}
+			
+			if(++nextJoint >= chain.size()){
+				if(sweepRotation < IK_SETTLE_DEGREES){
+					settled = true;
+					break;
+				}
+				
+				nextJoint = 0;
+				sweepRotation = 0.0;
+			}
+		}
+		
+		return changed;
+	}
+	
+	bool solving(){
+		return end < BONES_MAX_COUNT && !settled;
+	}
+	
+	void commit(){
+		if(end >= BONES_MAX_COUNT){
+			return;
+		}
+		
+		end = BONES_MAX_COUNT;
+		chain.clear();
+		settled = true;
+		
+		pose::edited();
+	}
+	
+	void cancel(){
+		if(end >= BONES_MAX_COUNT){
+			return;
+		}
+		
+		for(std::vector<struct chainJoint>::iterator it = chain.begin();it != chain.end();++it){
+			pose::setLocal(it->bone,it->translateX,it->translateY,it->scale,it->rotation);
+		}
+		
+		pose::update();
+		
+		end = BONES_MAX_COUNT;
+		chain.clear();
+		settled = true;
+	}
+}
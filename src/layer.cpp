@@ -2,6 +2,19 @@
 #include <cmath>
 #include <cstring>
 #include <cfloat>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+	#include <malloc.h>
+#else
+	#include <sys/mman.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define LAYER_SSE2
+	#include <emmintrin.h>
+#endif
 
 #include "view.hpp"
 #include "layer.hpp"
@@ -11,6 +24,7 @@
 #include "graphics.hpp"
 #include "skeleton.hpp"
 #include "fileIO.hpp"
+#include "history.hpp"
 
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Layer ---------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -104,12 +118,34 @@ class layer *layer::withNearestPoint(std::vector<class layer *> &layers){
 
 #define NO_NEAR_ELMNT (UINT_MAX)
 
+// Triangle counts past u16 are stored as this marker followed by a u32
+#define LAYER_LONG_COUNT_MARKER 0xffff
+
+// Layer files open with this marker followed by the u8 palette, older ones straight with the mesh
+#define LAYER_PALETTE_MARKER 0xfffe
+
+// Displays are split into chunks, within vecGL's u16 triangle count and small enough that
+// a brush stroke reloads little more than it wrote, vecGL having no partial buffer upload
+#define LAYER_CHUNK_TRIS 4096
+
+#define LAYER_MIN_CAPACITY 64
+
+// Vertex streams are carved from arenas, the mesh's shared between linked layers and the view's private,
+// streams aligned for cache lines and SIMD loads
+#define LAYER_ARENA_ALIGN 64
+#define LAYER_ARENA_ALIGNED(bytes) (((bytes) + LAYER_ARENA_ALIGN - 1) & ~(size_t)(LAYER_ARENA_ALIGN - 1))
+
+#define LAYER_HUGEPAGE_BYTES (2 * 1024 * 1024)
+
+// Triangle as kept by history: xy, uv, tbc and selection values
+#define LAYER_HIST_TRI_VALUE_COUNT (TRI_XY_VALUE_COUNT + TRI_UV_VALUE_COUNT + TRI_TBC_VALUE_COUNT + TRI_VERT_COUNT)
+
 bool vertLayer::NEARVERT_VALID(){
-	return nearVert < buffer.count * TRI_VERT_COUNT;
+	return nearVert < triCount * TRI_VERT_COUNT;
 }
 
 bool vertLayer::NEARTRI_VALID(){
-	return nearTri < buffer.count;
+	return nearTri < triCount;
 }
 
 uint16_t norm16_StoU(int16_t val){
@@ -131,64 +167,258 @@ int16_t norm32_bounded16(int32_t val){
 }
 
 // Utility Methods -------------------------------------------------------------------------------------------------------------------------------------------
-bool vertLayer::readMesh(FILE *in){
+void brushQuery(const int16_t *xy,uint32_t vertCount,int16_t x,int16_t y,unsigned int radius,std::vector<uint32_t> &hits){
+	hits.clear();
+	
+	float radiusSq = (float)radius * (float)radius;
+	uint32_t v = 0;
+	
+	#ifdef LAYER_SSE2
+	// Four interleaved x/y pairs at a time, distances in floats as 16-bit differences square past 32 bits
+	const __m128 cursor = _mm_setr_ps(x,y,x,y);
+	const __m128 limit = _mm_set1_ps(radiusSq);
+	
+	for(;v + 4 <= vertCount;v += 4){
+		__m128i pairs = _mm_loadu_si128((const __m128i *)(xy + v * 2));
+		
+		__m128 lo = _mm_sub_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(pairs,pairs),16)),cursor);
+		__m128 hi = _mm_sub_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(pairs,pairs),16)),cursor);
+		
+		lo = _mm_mul_ps(lo,lo);
+		hi = _mm_mul_ps(hi,hi);
+		
+		__m128 dist = _mm_add_ps(_mm_shuffle_ps(lo,hi,_MM_SHUFFLE(2,0,2,0)),_mm_shuffle_ps(lo,hi,_MM_SHUFFLE(3,1,3,1)));
+		int mask = _mm_movemask_ps(_mm_cmplt_ps(dist,limit));
+		
+		while(mask != 0){
+			unsigned int bit = mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3;
+			
+			hits.push_back(v + bit);
+			mask &= mask - 1;
+		}
+	}
+	#endif
+	
+	for(;v < vertCount;++v){
+		float dX = (float)xy[v * 2 + 0] - (float)x;
+		float dY = (float)xy[v * 2 + 1] - (float)y;
+		
+		if(dX * dX + dY * dY < radiusSq){
+			hits.push_back(v);
+		}
+	}
+}
+
+size_t meshCarve(unsigned char *arena,uint32_t capacity,struct vecTrisBuf *buffer){
+	// Streams laid out back to back, each starting on an aligned boundary
+	size_t xyBytes = LAYER_ARENA_ALIGNED((size_t)capacity * TRI_XY_VALUE_COUNT * sizeof(int16_t));
+	size_t uvBytes = LAYER_ARENA_ALIGNED((size_t)capacity * TRI_UV_VALUE_COUNT * sizeof(uint16_t));
+	size_t tbcBytes = LAYER_ARENA_ALIGNED((size_t)capacity * TRI_TBC_VALUE_COUNT * sizeof(uint8_t));
+	
+	if(arena != NULL){
+		buffer->xy = (int16_t *)arena;
+		buffer->uv = (uint16_t *)(arena + xyBytes);
+		buffer->tbc = (uint8_t *)(arena + xyBytes + uvBytes);
+	}
+	
+	return xyBytes + uvBytes + tbcBytes;
+}
+
+size_t viewCarve(unsigned char *arena,uint32_t capacity,struct vecTrisBuf *disp,unsigned char **selVerts){
+	// Display streams as the mesh's, followed by the selection
+	size_t dispBytes = meshCarve(arena,capacity,disp);
+	size_t selBytes = LAYER_ARENA_ALIGNED((size_t)capacity * TRI_VERT_COUNT * sizeof(unsigned char));
+	
+	if(arena != NULL){
+		*selVerts = arena + dispBytes;
+	}
+	
+	return dispBytes + selBytes;
+}
+
+unsigned char *arenaAlloc(size_t bytes){
+	void *arena = NULL;
+	
+	#ifdef _WIN32
+	arena = _aligned_malloc(bytes,LAYER_ARENA_ALIGN);
+	#else
+	// Large arenas aligned to, and advised as, huge pages where supported
+	size_t align = bytes >= LAYER_HUGEPAGE_BYTES ? LAYER_HUGEPAGE_BYTES : LAYER_ARENA_ALIGN;
+	
+	if(posix_memalign(&arena,align,bytes) != 0){
+		arena = NULL;
+	}
+	
+	#ifdef MADV_HUGEPAGE
+	if(arena != NULL && bytes >= LAYER_HUGEPAGE_BYTES){
+		madvise(arena,bytes,MADV_HUGEPAGE);
+	}
+	#endif
+	#endif
+	
+	if(arena == NULL){
+		throw std::bad_alloc();
+	}
+	
+	return (unsigned char *)arena;
+}
+
+void arenaFree(unsigned char *arena){
+	#ifdef _WIN32
+	_aligned_free(arena);
+	#else
+	free(arena);
+	#endif
+}
+
+struct layerMesh *meshAlloc(uint32_t capacity){
+	struct layerMesh *mesh = new layerMesh;
+	
+	mesh->maxTris = capacity;
+	mesh->arenaBytes = meshCarve(NULL,capacity,NULL);
+	mesh->arena = arenaAlloc(mesh->arenaBytes);
+	mesh->refs = 1;
+	mesh->trisStale = true;
+	mesh->dirtyFirst = 0;
+	mesh->dirtyEnd = 0;
+	
+	return mesh;
+}
+
+void meshRelease(struct layerMesh *mesh){
+	if(mesh == NULL || --(mesh->refs) > 0){
+		return;
+	}
+	
+	arenaFree(mesh->arena);
+	
+	for(std::vector<struct vecTris *>::iterator it = mesh->tris.begin();it != mesh->tris.end();++it){
+		deleteVecTris(*it);
+	}
+	
+	delete mesh;
+}
+
+void vertLayer::arenaSet(uint32_t capacity){
+	maxTris = capacity < LAYER_MIN_CAPACITY ? LAYER_MIN_CAPACITY : capacity;
+	
+	mesh = meshAlloc(maxTris);
+	meshCarve(mesh->arena,maxTris,&buffer);
+	
+	arenaBytes = viewCarve(NULL,maxTris,NULL,NULL);
+	arena = arenaAlloc(arenaBytes);
+	viewCarve(arena,maxTris,&disp,&selVerts);
+}
+
+void vertLayer::meshOwn(){
+	// Copy on first write while shared, the copy's display uploaded anew
+	if(mesh->refs > 1){
+		struct layerMesh *owned = meshAlloc(maxTris);
+		
+		memcpy(owned->arena,mesh->arena,mesh->arenaBytes);
+		meshRelease(mesh);
+		
+		mesh = owned;
+		meshCarve(mesh->arena,maxTris,&buffer);
+	}
+}
+
+void vertLayer::meshWrite(){
+	meshOwn();
+	mesh->trisStale = true;
+}
+
+void vertLayer::meshWrite(uint32_t firstTri,uint32_t endTri){
+	// Writes confined to a triangle range, only their chunks uploaded again
+	meshOwn();
+	
+	if(mesh->dirtyEnd > mesh->dirtyFirst){
+		mesh->dirtyFirst = firstTri < mesh->dirtyFirst ? firstTri : mesh->dirtyFirst;
+		mesh->dirtyEnd = endTri > mesh->dirtyEnd ? endTri : mesh->dirtyEnd;
+	}else{
+		mesh->dirtyFirst = firstTri;
+		mesh->dirtyEnd = endTri;
+	}
+	
+	if(dirtyEnd > dirtyFirst){
+		dirtyFirst = firstTri < dirtyFirst ? firstTri : dirtyFirst;
+		dirtyEnd = endTri > dirtyEnd ? endTri : dirtyEnd;
+	}else{
+		dirtyFirst = firstTri;
+		dirtyEnd = endTri;
+	}
+}
+
+bool vertLayer::meshShared(){
+	return mesh != NULL && mesh->refs > 1;
+}
+
+bool vertLayer::readMesh(FILE *in,uint16_t shortCount){
 	bool success = true,iSuccess;
 	
-	if(!fIO::u16::read(&(buffer.count),in)){
+	// Triangle count, its leading u16 read by the caller, as u16 or as a marker followed by a u32
+	if(shortCount != LAYER_LONG_COUNT_MARKER){
+		triCount = shortCount;
+	}else if(!fIO::u32::read(&triCount,in)){
 		return false;
 	}
 	
-	buffer.xy = new int16_t[buffer.count * TRI_XY_VALUE_COUNT];
-	buffer.uv = new uint16_t[buffer.count * TRI_UV_VALUE_COUNT];
-	buffer.tbc = new uint8_t[buffer.count * TRI_TBC_VALUE_COUNT];
+	arenaSet(triCount);
 	
-	for(unsigned int i = 0;success && i < buffer.count * TRI_VERT_COUNT;++i){
+	for(unsigned int i = 0;success && i < triCount * TRI_VERT_COUNT;++i){
 		iSuccess = fIO::s16::read(&(VERT_X(&buffer,i)),in) && fIO::s16::read(&(VERT_Y(&buffer,i)),in);
 		success = success && iSuccess;
 	}
 	
-	for(unsigned int i = 0;success && i < buffer.count * TRI_VERT_COUNT;++i){
+	for(unsigned int i = 0;success && i < triCount * TRI_VERT_COUNT;++i){
 		iSuccess = fIO::u16::read(&(VERT_U(&buffer,i)),in) && fIO::u16::read(&(VERT_V(&buffer,i)),in);
 		success = success && iSuccess;
 	}
 	
-	for(unsigned int i = 0;success && i < buffer.count * TRI_VERT_COUNT;++i){
+	for(unsigned int i = 0;success && i < triCount * TRI_VERT_COUNT;++i){
 		iSuccess = fIO::u8::read(&(VERT_TYPE(&buffer,i)),in) && fIO::u8::read(&(VERT_BONE(&buffer,i)),in) && fIO::u8::read(&(VERT_COLOR(&buffer,i)),in);
 		success = success && iSuccess;
 	}
 	
 	if(!success){
-		delete[] buffer.xy;
-		delete[] buffer.uv;
-		delete[] buffer.tbc;
+		meshRelease(mesh);
+		mesh = NULL;
+		
+		arenaFree(arena);
+		arena = NULL;
 	}
 	
 	return success;
 }
 
 bool vertLayer::init_ReadLayer(FILE *in){
-	if(!readMesh(in)){
+	// Palette, if saved, ahead of the mesh's triangle count
+	uint16_t lead;
+	uint8_t filePalette = 0;
+	
+	if(!fIO::u16::read(&lead,in)){
 		return false;
 	}
 	
-	// Parameters
-	maxTris = buffer.count;
+	if(lead == LAYER_PALETTE_MARKER && (!fIO::u8::read(&filePalette,in) || !fIO::u16::read(&lead,in))){
+		return false;
+	}
 	
-	// Buffers
-	disp.count = buffer.count;
-	disp.xy = new int16_t[maxTris * TRI_XY_VALUE_COUNT];
-	disp.uv = new uint16_t[maxTris * TRI_UV_VALUE_COUNT];
-	disp.tbc = new uint8_t[maxTris * TRI_TBC_VALUE_COUNT];
+	if(!readMesh(in,lead)){
+		return false;
+	}
+	
+	paletteSet(filePalette);
 	
 	modified = true;
 	
 	// Selections
 	bool success = true;
-	selVerts = new unsigned char[maxTris * TRI_VERT_COUNT];
+	memset(selVerts,0,maxTris * TRI_VERT_COUNT * sizeof(unsigned char));
 	
 	selVertCount = 0;
 	
-	for(unsigned int i = 0;success && i < buffer.count * TRI_VERT_COUNT;++i){
+	for(unsigned int i = 0;success && i < triCount * TRI_VERT_COUNT;++i){
 		success = success && fIO::u8::read(selVerts + i,in);
 		
 		if(success && selVerts[i]){
@@ -201,43 +431,83 @@ bool vertLayer::init_ReadLayer(FILE *in){
 }
 
 void vertLayer::init_Blank(unsigned int maxTriCount){
-	// Parameters
-	maxTris = maxTriCount;
-	
 	// Buffers
-	buffer.count = 0;
-	buffer.xy = new int16_t[maxTris * TRI_XY_VALUE_COUNT];
-	buffer.uv = new uint16_t[maxTris * TRI_UV_VALUE_COUNT];
-	buffer.tbc = new uint8_t[maxTris * TRI_TBC_VALUE_COUNT];
-	
-	disp.count = 0;
-	disp.xy = new int16_t[maxTris * TRI_XY_VALUE_COUNT];
-	disp.uv = new uint16_t[maxTris * TRI_UV_VALUE_COUNT];
-	disp.tbc = new uint8_t[maxTris * TRI_TBC_VALUE_COUNT];
+	triCount = 0;
+	arenaSet(maxTriCount);
 	
 	modified = false;
 	
 	// Selections
-	selVerts = new unsigned char[maxTris * TRI_VERT_COUNT];
 	memset(selVerts,0,maxTris * TRI_VERT_COUNT * sizeof(unsigned char));
 	
 	selVertCount = 0;
 }
 
 void vertLayer::end(){
-	// Buffers
-	delete[] buffer.xy;
-	delete[] buffer.uv;
-	delete[] buffer.tbc;
+	// Buffers & Selections
+	meshRelease(mesh);
+	mesh = NULL;
 	
-	delete[] disp.xy;
-	delete[] disp.uv;
-	delete[] disp.tbc;
+	arenaFree(arena);
+	arena = NULL;
 	
-	deleteVecTris(dispTris);
+	for(std::vector<struct vecTris *>::iterator it = dispTris.begin();it != dispTris.end();++it){
+		deleteVecTris(*it);
+	}
 	
-	// Selections
-	delete[] selVerts;
+	dispTris.clear();
+}
+
+void vertLayer::grow(uint32_t minTriCount){
+	if(minTriCount <= maxTris){
+		return;
+	}
+	
+	// Geometric growth, for amortized constant-time appends
+	uint32_t newMaxTris = maxTris;
+	
+	while(newMaxTris < minTriCount){
+		newMaxTris = newMaxTris > UINT32_MAX / (2 * TRI_XY_VALUE_COUNT) ? minTriCount : newMaxTris * 2;
+	}
+	
+	// Buffer contents carry over into an unshared mesh
+	struct layerMesh *newMesh = meshAlloc(newMaxTris);
+	struct vecTrisBuf newBuffer;
+	
+	meshCarve(newMesh->arena,newMaxTris,&newBuffer);
+	
+	memcpy(newBuffer.xy,buffer.xy,triCount * TRI_XY_VALUE_COUNT * sizeof(int16_t));
+	memcpy(newBuffer.uv,buffer.uv,triCount * TRI_UV_VALUE_COUNT * sizeof(uint16_t));
+	memcpy(newBuffer.tbc,buffer.tbc,triCount * TRI_TBC_VALUE_COUNT * sizeof(uint8_t));
+	
+	meshRelease(mesh);
+	mesh = newMesh;
+	
+	// Selections carry over, the display buffer is rebuilt from the mesh anyway
+	size_t newArenaBytes = viewCarve(NULL,newMaxTris,NULL,NULL);
+	unsigned char *newArena = arenaAlloc(newArenaBytes);
+	
+	struct vecTrisBuf newDisp;
+	unsigned char *newSelVerts;
+	
+	viewCarve(newArena,newMaxTris,&newDisp,&newSelVerts);
+	
+	memcpy(newSelVerts,selVerts,triCount * TRI_VERT_COUNT * sizeof(unsigned char));
+	memset(newSelVerts + triCount * TRI_VERT_COUNT,0,(newMaxTris - triCount) * TRI_VERT_COUNT * sizeof(unsigned char));
+	
+	arenaFree(arena);
+	
+	arena = newArena;
+	arenaBytes = newArenaBytes;
+	maxTris = newMaxTris;
+	
+	buffer = newBuffer;
+	
+	disp.xy = newDisp.xy;
+	disp.uv = newDisp.uv;
+	disp.tbc = newDisp.tbc;
+	
+	selVerts = newSelVerts;
 }
 
 void vertLayer::copyTri(struct vecTrisBuf *src,unsigned int srcI,struct vecTrisBuf *dest,unsigned int destI){
@@ -322,28 +592,15 @@ void vertLayer::vertModifiers_ApplyTo(struct vecTrisBuf *vertModified){
 		return;
 	}
 	
-	// Apply modifier according to global state
+	// Apply modifier according to global state, in one pass over the selection
 	switch(state::get()){
 		case STATE_ATOP_TRANSFORM_XY:
-			for(unsigned int i = 0;i < vertModified->count * TRI_VERT_COUNT;++i){
-				if(selVerts[i]){
-					(*vertModifier)(&(VERT_X(vertModified,i)),&(VERT_Y(vertModified,i)));
-				}
-			}
+			(*vertModifierBatch)(vertModified->xy,selVerts,triCount * TRI_VERT_COUNT,0);
 			
 			break;
 		case STATE_ATOP_TRANSFORM_UV:
-			for(unsigned int i = 0;i < vertModified->count * TRI_VERT_COUNT;++i){
-				if(selVerts[i]){
-					int16_t nU = norm16_UtoS(VERT_U(vertModified,i));
-					int16_t nV = norm16_UtoS(VERT_V(vertModified,i));
-					
-					(*vertModifier)(&nU,&nV);
-					
-					VERT_U(vertModified,i) = norm16_StoU(nU);
-					VERT_V(vertModified,i) = norm16_StoU(nV);
-				}
-			}
+			// Unsigned UVs flipped to and from signed by their top bit, as norm16_UtoS/norm16_StoU
+			(*vertModifierBatch)((int16_t *)vertModified->uv,selVerts,triCount * TRI_VERT_COUNT,0x8000);
 			
 			break;
 		default:
@@ -355,7 +612,10 @@ void vertLayer::vertModifiers_ApplyTo(struct vecTrisBuf *vertModified){
 vertLayer::vertLayer(unsigned int maxTriCount,FILE *in,bool *readSuccess){
 	// Default States ---------------------------------------------
 	// Buffer display
-	dispTris = NULL;
+	dispTris.clear();
+	
+	mesh = NULL;
+	arena = NULL;
 	
 	// Draw State Tracking
 	lastDraw = state::getDraw();
@@ -363,6 +623,7 @@ vertLayer::vertLayer(unsigned int maxTriCount,FILE *in,bool *readSuccess){
 	
 	// Vertex Modifiers
 	vertModifier = NULL;
+	vertModifierBatch = NULL;
 	vertModifierEnabled = NULL;
 	
 	// Near elements
@@ -376,7 +637,56 @@ vertLayer::vertLayer(unsigned int maxTriCount,FILE *in,bool *readSuccess){
 	}
 }
 
+vertLayer::vertLayer(class vertLayer *src){
+	// Default States ---------------------------------------------
+	nameSet(src->nameGet());
+	palette = src->palette;
+	
+	if(!src->visible()){
+		visibilityToggle();
+	}
+	
+	offsetX = src->offsetX;
+	offsetY = src->offsetY;
+	
+	// Buffer display
+	dispTris.clear();
+	modified = true;
+	
+	// Draw State Tracking
+	lastDraw = state::getDraw();
+	lastBone = 0;
+	
+	// Vertex Modifiers
+	vertModifier = src->vertModifier;
+	vertModifierBatch = src->vertModifierBatch;
+	vertModifierEnabled = src->vertModifierEnabled;
+	
+	// Near elements
+	nearVert = NO_NEAR_ELMNT;
+	nearTri = NO_NEAR_ELMNT;
+	
+	// Buffer shared until either layer writes to it -----------------------------------------
+	triCount = src->triCount;
+	maxTris = src->maxTris;
+	
+	mesh = src->mesh;
+	++(mesh->refs);
+	
+	buffer = src->buffer;
+	
+	// Display & Selection, duplicated as one arena -----------------------------------------
+	selVertCount = src->selVertCount;
+	
+	arenaBytes = src->arenaBytes;
+	arena = arenaAlloc(arenaBytes);
+	
+	memcpy(arena,src->arena,arenaBytes);
+	viewCarve(arena,maxTris,&disp,&selVerts);
+}
+
 vertLayer::~vertLayer(){
+	hist::forget(this);
 	end();
 }
 
@@ -388,21 +698,26 @@ enum layerType vertLayer::type(){
 bool vertLayer::writeMesh(FILE *out){
 	bool success = true,iSuccess;
 	
-	if(!fIO::u16::write(buffer.count,out)){
+	// Triangle count, past u16 as a marker followed by a u32
+	if(triCount < LAYER_LONG_COUNT_MARKER){
+		if(!fIO::u16::write(triCount,out)){
+			return false;
+		}
+	}else if(!fIO::u16::write(LAYER_LONG_COUNT_MARKER,out) || !fIO::u32::write(triCount,out)){
 		return false;
 	}
 	
-	for(unsigned int i = 0;success && i < buffer.count * TRI_VERT_COUNT;++i){
+	for(unsigned int i = 0;success && i < triCount * TRI_VERT_COUNT;++i){
 		iSuccess = fIO::s16::write(VERT_X(&buffer,i),out) && fIO::s16::write(VERT_Y(&buffer,i),out);
 		success = success && iSuccess;
 	}
 	
-	for(unsigned int i = 0;success && i < buffer.count * TRI_VERT_COUNT;++i){
+	for(unsigned int i = 0;success && i < triCount * TRI_VERT_COUNT;++i){
 		iSuccess = fIO::u16::write(VERT_U(&buffer,i),out) && fIO::u16::write(VERT_V(&buffer,i),out);
 		success = success && iSuccess;
 	}
 	
-	for(unsigned int i = 0;success && i < buffer.count * TRI_VERT_COUNT;++i){
+	for(unsigned int i = 0;success && i < triCount * TRI_VERT_COUNT;++i){
 		iSuccess = fIO::u8::write(VERT_TYPE(&buffer,i),out) && fIO::u8::write(VERT_BONE(&buffer,i),out) && fIO::u8::write(VERT_COLOR(&buffer,i),out);
 		success = success && iSuccess;
 	}
@@ -411,6 +726,11 @@ bool vertLayer::writeMesh(FILE *out){
 }
 
 bool vertLayer::writeLayer(FILE *out){
+	// Palette
+	if(!fIO::u16::write(LAYER_PALETTE_MARKER,out) || !fIO::u8::write(palette,out)){
+		return false;
+	}
+	
 	// Buffer
 	if(!writeMesh(out)){
 		return false;
@@ -419,26 +739,86 @@ bool vertLayer::writeLayer(FILE *out){
 	// Selection
 	bool success = true;
 	
-	for(unsigned int i = 0;success && i < buffer.count * TRI_VERT_COUNT;++i){
+	for(unsigned int i = 0;success && i < triCount * TRI_VERT_COUNT;++i){
 		success = success && fIO::u8::write(selVerts[i],out);
 	}
 	
 	return success;
 }
 
+// Custom color palette -------------------------------------------------------------------------------------------------------------------------------------------
+void vertLayer::paletteSet(unsigned char newPalette){
+	palette = newPalette % CLR_CSTM_PALETTE_COUNT;
+}
+
+unsigned char vertLayer::paletteGet(){
+	return palette;
+}
+
+// Instancing -------------------------------------------------------------------------------------------------------------------------------------------
+void vertLayer::offsetSet(int16_t x,int16_t y){
+	offsetX = x;
+	offsetY = y;
+}
+
+int16_t vertLayer::offsetGetX(){
+	return offsetX;
+}
+
+int16_t vertLayer::offsetGetY(){
+	return offsetY;
+}
+
+bool vertLayer::linked(){
+	return meshShared();
+}
 
 // Vertex Modifiers -------------------------------------------------------------------------------------------------------------------------------------------
-void vertLayer::vertModifiers_Set(void (*mod)(int16_t*,int16_t*),bool (*modEnabled)()){
+void vertLayer::vertModifiers_Set(void (*mod)(int16_t*,int16_t*),void (*modBatch)(int16_t*,const unsigned char*,unsigned int,uint16_t),bool (*modEnabled)()){
 	vertModifier = mod;
+	vertModifierBatch = modBatch;
 	vertModifierEnabled = modEnabled;
 }
 
 bool vertLayer::vertModifiers_Applicable(){
-	return vertModifier != NULL && vertModifierEnabled != NULL && visible() && (*vertModifierEnabled)() && selVertCount > 0;
+	return vertModifier != NULL && vertModifierBatch != NULL && vertModifierEnabled != NULL && visible() && (*vertModifierEnabled)() && selVertCount > 0;
 }
 
 void vertLayer::vertModifiers_Apply(){
+	if(!vertModifiers_Applicable()){
+		return;
+	}
+	
+	// Only the selected vertices' prior values are kept
+	struct histRecord rec;
+	
+	rec.target = this;
+	rec.op = state::get() == STATE_ATOP_TRANSFORM_UV ? HIST_UV : HIST_XY;
+	
+	rec.indices.reserve(selVertCount);
+	rec.values.reserve(selVertCount * 2);
+	
+	for(unsigned int i = 0;i < triCount * TRI_VERT_COUNT;++i){
+		if(!selVerts[i]){
+			continue;
+		}
+		
+		rec.indices.push_back(i);
+		
+		if(rec.op == HIST_UV){
+			rec.values.push_back(VERT_U(&buffer,i));
+			rec.values.push_back(VERT_V(&buffer,i));
+		}else{
+			rec.values.push_back(VERT_X(&buffer,i));
+			rec.values.push_back(VERT_Y(&buffer,i));
+		}
+	}
+	
+	meshWrite();
 	vertModifiers_ApplyTo(&buffer);
+	
+	modified = true;
+	hist::record(rec);
 }
 
 // Inherited -------------------------------------------------------------------------------------------------------------------------------------------
@@ -456,14 +836,27 @@ bool vertLayer::nearestPoint_Find(unsigned int radius,unsigned char currBone){
 	int16_t iX = vw::norm::toI(vw::norm::cursorPos().x);
 	int16_t iY = vw::norm::toI(vw::norm::cursorPos().y);
 	
+	// Posed positions are skinned in one batch
+	bool posed = renderVertMode() == VERT_MODE_POSE_XY;
+	
+	if(posed && triCount > 0){
+		skinned.resize(triCount * TRI_VERT_COUNT * 2);
+		pose::skinVerts(&buffer,0,triCount * TRI_VERT_COUNT,&skinned[0]);
+	}
+	
 	// Searching for nearest vertex index
 	uint64_t dist,nearDist = UINT64_MAX;
 	sf::Vector2<int32_t> vPs[TRI_VERT_COUNT];
 	
-	for(unsigned int i = 0;i < buffer.count;++i){
+	for(unsigned int i = 0;i < triCount;++i){
 		// Calculate triangle vertex positions
 		for(unsigned int j = 0;j < TRI_VERT_COUNT;++j){
-			vPs[j] = modedVertPosition(TRI_V(i,j));
+			if(posed){
+				vPs[j].x = skinned[TRI_V(i,j) * 2 + 0];
+				vPs[j].y = skinned[TRI_V(i,j) * 2 + 1];
+			}else{
+				vPs[j] = modedVertPosition(TRI_V(i,j));
+			}
 		}
 		
 		// Perform closest-vertex search
@@ -553,11 +946,65 @@ class vertLayer *vertLayer::withNearestPoint(std::vector<class vertLayer *> &lay
 }
 
 // Drawing -------------------------------------------------------------------------------------------------------------------------------------------
+void drawChunks(struct vecTrisBuf *src,uint32_t triCount,std::vector<struct vecTris *> &chunks,uint32_t reloadFirst,uint32_t reloadEnd,unsigned int vert,unsigned int frag,unsigned int pfl,unsigned char palette,bool wireframe,float offsetX,float offsetY){
+	// Chunks overlapping the reload range loaded anew, the rest drawn as they are
+	unsigned int chunkCount = (triCount + LAYER_CHUNK_TRIS - 1) / LAYER_CHUNK_TRIS;
+	
+	while(chunks.size() > chunkCount){
+		deleteVecTris(chunks.back());
+		chunks.pop_back();
+	}
+	
+	chunks.resize(chunkCount,NULL);
+	
+	for(unsigned int c = 0;c < chunkCount;++c){
+		uint32_t first = c * LAYER_CHUNK_TRIS;
+		
+		if(reloadFirst >= reloadEnd || reloadEnd <= first || reloadFirst >= first + LAYER_CHUNK_TRIS){
+			render::loadAndDrawTris(NULL,&chunks[c],vert,frag,pfl,palette,wireframe,offsetX,offsetY);
+			
+			continue;
+		}
+		
+		struct vecTrisBuf chunk;
+		
+		chunk.count = (triCount - first) < LAYER_CHUNK_TRIS ? (triCount - first) : LAYER_CHUNK_TRIS;
+		chunk.xy = src->xy + first * TRI_XY_VALUE_COUNT;
+		chunk.uv = src->uv + first * TRI_UV_VALUE_COUNT;
+		chunk.tbc = src->tbc + first * TRI_TBC_VALUE_COUNT;
+		
+		render::loadAndDrawTris(&chunk,&chunks[c],vert,frag,pfl,palette,wireframe,offsetX,offsetY);
+	}
+}
+
+void vertLayer::dispUpdate(uint32_t firstTri,uint32_t endTri,unsigned char currBone){
+	// Copying to display buffer
+	memcpy(disp.xy + firstTri * TRI_XY_VALUE_COUNT,buffer.xy + firstTri * TRI_XY_VALUE_COUNT,(endTri - firstTri) * TRI_XY_VALUE_COUNT * sizeof(int16_t));
+	memcpy(disp.uv + firstTri * TRI_UV_VALUE_COUNT,buffer.uv + firstTri * TRI_UV_VALUE_COUNT,(endTri - firstTri) * TRI_UV_VALUE_COUNT * sizeof(uint16_t));
+	memcpy(disp.tbc + firstTri * TRI_TBC_VALUE_COUNT,buffer.tbc + firstTri * TRI_TBC_VALUE_COUNT,(endTri - firstTri) * TRI_TBC_VALUE_COUNT * sizeof(uint8_t));
+	
+	// Applying modifiers if needed, only ever over the whole display
+	if(vertModifiers_Applicable()){
+		vertModifiers_ApplyTo(&disp);
+	}
+	
+	// Set vertex colors if applicable
+	if(renderClrPfl() == CLR_PFL_EDITOR){
+		for(unsigned int i = firstTri * TRI_VERT_COUNT;i < endTri * TRI_VERT_COUNT;++i){
+			VERT_COLOR(&disp,i) = selVerts[i] ? CLR_EDITR_HILIGHT : CLR_EDITR_OFFWHITE;
+		}
+	}else if(renderClrPfl() == CLR_PFL_RANBW){
+		for(unsigned int i = firstTri * TRI_VERT_COUNT;i < endTri * TRI_VERT_COUNT;++i){
+			VERT_COLOR(&disp,i) = (VERT_BONE(&buffer,i) == currBone ? hud::markColorI(VERT_BONE(&buffer,i)) : CLR_RANBW_NULL);
+		}
+	}
+}
+
 void vertLayer::draw(){
-	draw(0,false,false);
+	draw(0,false);
 }
 
-void vertLayer::draw(unsigned char currBone,bool wireframe,bool showNearestPoint){
+void vertLayer::draw(unsigned char currBone,bool wireframe){
 	if(!visible()){
 		return;
 	}
@@ -571,53 +1018,85 @@ void vertLayer::draw(unsigned char currBone,bool wireframe,bool showNearestPoint
 	}
 	
 	// Draw buffer -------------------------------------------	
-	// Display tris updasion and rendering
-	if(modified || vertModifiers_Applicable()){
-		// Copying to display buffer
-		disp.count = buffer.count;
-		memcpy(disp.xy,buffer.xy,buffer.count * TRI_XY_VALUE_COUNT * sizeof(int16_t));
-		memcpy(disp.uv,buffer.uv,buffer.count * TRI_UV_VALUE_COUNT * sizeof(uint16_t));
-		memcpy(disp.tbc,buffer.tbc,buffer.count * TRI_TBC_VALUE_COUNT * sizeof(uint8_t));
-		
-		// Applying modifiers if needed
-		if(vertModifiers_Applicable()){
-			vertModifiers_ApplyTo(&disp);
+	// Unaltered mesh, its display shared by linked layers, each at its own offset in view
+	if(renderClrPfl() == CLR_PFL_CSTM && !vertModifiers_Applicable()){
+		float dX = state::getDraw() == D_STATE_VIEW ? vw::norm::toD(offsetX) : 0.0;
+		float dY = state::getDraw() == D_STATE_VIEW ? vw::norm::toD(offsetY) : 0.0;
+		
+		// Reloaded whole when stale, otherwise only where written
+		uint32_t first = mesh->trisStale ? 0 : mesh->dirtyFirst;
+		uint32_t end = mesh->trisStale ? triCount : mesh->dirtyEnd;
+		
+		drawChunks(&buffer,triCount,mesh->tris,first,end,renderVertMode(),renderFragMode(),renderClrPfl(),palette,wireframe,dX,dY);
+		
+		mesh->trisStale = false;
+		mesh->dirtyFirst = 0;
+		mesh->dirtyEnd = 0;
+	}else{
+		// Display tris updasion, whole when modified, otherwise only where written
+		uint32_t first = 0;
+		uint32_t end = triCount;
+		
+		if(!modified && !vertModifiers_Applicable()){
+			first = dirtyFirst;
+			end = dirtyEnd;
 		}
 		
-		// Set vertex colors if applicable
-		if(renderClrPfl() == CLR_PFL_EDITOR){
-			for(unsigned int i = 0;i < buffer.count * TRI_VERT_COUNT;++i){
-				VERT_COLOR(&disp,i) = selVerts[i] ? CLR_EDITR_HILIGHT : CLR_EDITR_OFFWHITE;
-			}
-		}else if(renderClrPfl() == CLR_PFL_RANBW){
-			for(unsigned int i = 0;i < buffer.count * TRI_VERT_COUNT;++i){
-				VERT_COLOR(&disp,i) = (VERT_BONE(&buffer,i) == currBone ? hud::markColorI(VERT_BONE(&buffer,i)) : CLR_RANBW_NULL);
-			}
+		if(end > first){
+			dispUpdate(first,end,currBone);
 		}
 		
-		// Render
-		render::loadAndDrawTris(&disp,&dispTris,renderVertMode(),renderFragMode(),renderClrPfl(),wireframe);
-	}else{
-		// Default rendering
-		render::loadAndDrawTris(NULL,&dispTris,renderVertMode(),renderFragMode(),renderClrPfl(),wireframe);
+		drawChunks(&disp,triCount,dispTris,first,end,renderVertMode(),renderFragMode(),renderClrPfl(),palette,wireframe,0.0,0.0);
 	}
 	
 	// State finalization
 	modified = vertModifiers_Applicable();
 	
+	dirtyFirst = 0;
+	dirtyEnd = 0;
+	
 	// None-pose indicators ahead -----------------------------------------------------------------------------------------------------------------------------------
 	if(renderVertMode() == VERT_MODE_POSE_XY){
 		return;
 	}
 	
+	// Draw convex handles -------------------------------------------
+	sf::Vector2<int16_t> vP16;
+	sf::Vector2<int32_t> vP32;
+	
+	for(unsigned int i = 0;i < triCount * TRI_VERT_COUNT;++i){
+		if(VERT_TYPE(&buffer,i) != TRI_TYPE_CONVEX || (i % 3) != 0){
+			continue;
+		}
+		
+		// Vertex position retrieval and adjustment as needed
+		vP32 = modedVertPosition(i);
+		vP16.x = vP32.x;
+		vP16.y = vP32.y;
+		
+		if(vertModifiers_Applicable() && selVerts[i]){
+			(*vertModifier)(&(vP16.x),&(vP16.y));
+		}
+		
+		// Drawing
+		hud::drawCircle(vP16.x,vP16.y,false,POINT_RADIUS,clr::get(clr::PFL_EDITR,selVerts[i] ? CLR_EDITR_HILIGHT : CLR_EDITR_OFFWHITE,clr::ALF_HALF));
+	}
+}
+
+void vertLayer::drawNearestPoint(){
+	// Overlay only, drawn atop the cached scene
+	if(!visible() || renderVertMode() == VERT_MODE_POSE_XY){
+		return;
+	}
+	
 	// Draw nearest vertex/currrent triangle indicator -------------------------------------------
-	if(showNearestPoint && nearVert != NO_NEAR_ELMNT){
+	if(nearVert != NO_NEAR_ELMNT){
 		// Color calculation
 		uint32_t indicatorColor;
 		
 		switch(renderClrPfl()){
 			case CLR_PFL_CSTM:
-				indicatorColor = (clr::inverse(clrCstm::get(VERT_COLOR(&disp,nearVert))) & 0xffffff00) | clr::getAlpha(clr::ALF_HALF);
+				indicatorColor = (clr::inverse(clrCstm::get(palette,VERT_COLOR(&disp,nearVert))) & 0xffffff00) | clr::getAlpha(clr::ALF_HALF);
 				
 				break;
 			case CLR_PFL_RANBW:
@@ -644,28 +1123,6 @@ void vertLayer::draw(unsigned char currBone,bool wireframe,bool showNearestPoint
 			TRI_VERT_MARKER_RADIUS,indicatorColor
 		);
 	}
-	
-	// Draw convex handles -------------------------------------------
-	sf::Vector2<int16_t> vP16;
-	sf::Vector2<int32_t> vP32;
-	
-	for(unsigned int i = 0;i < buffer.count * TRI_VERT_COUNT;++i){
-		if(VERT_TYPE(&buffer,i) != TRI_TYPE_CONVEX || (i % 3) != 0){
-			continue;
-		}
-		
-		// Vertex position retrieval and adjustment as needed
-		vP32 = modedVertPosition(i);
-		vP16.x = vP32.x;
-		vP16.y = vP32.y;
-		
-		if(vertModifiers_Applicable() && selVerts[i]){
-			(*vertModifier)(&(vP16.x),&(vP16.y));
-		}
-		
-		// Drawing
-		hud::drawCircle(vP16.x,vP16.y,false,POINT_RADIUS,clr::get(clr::PFL_EDITR,selVerts[i] ? CLR_EDITR_HILIGHT : CLR_EDITR_OFFWHITE,clr::ALF_HALF));
-	}
 }
 
 // Selections -------------------------------------------------------------------------------------------------------------------------------------------
@@ -676,6 +1133,8 @@ bool vertLayer::selectVert_Nearest(bool toggle,bool set){
 	
 	bool newState = toggle ? !selVerts[nearVert] : set;
 	
+	hist_RecordSelect(nearVert,1,newState);
+	
 	selVertCount += selVerts[nearVert] == newState ? 0 : ((char)newState * 2 - 1);
 	selVerts[nearVert] = newState;
 	
@@ -685,14 +1144,18 @@ bool vertLayer::selectVert_Nearest(bool toggle,bool set){
 }
 
 void vertLayer::selectVert_All(){
-	memset(selVerts,1,buffer.count * TRI_VERT_COUNT * sizeof(unsigned char));
-	selVertCount = buffer.count * TRI_VERT_COUNT;
+	hist_RecordSelect(0,triCount * TRI_VERT_COUNT,true);
+	
+	memset(selVerts,1,triCount * TRI_VERT_COUNT * sizeof(unsigned char));
+	selVertCount = triCount * TRI_VERT_COUNT;
 	
 	modified = true;
 }
 
 void vertLayer::selectVert_Clear(){
-	memset(selVerts,0,maxTris * TRI_VERT_COUNT * sizeof(unsigned char));
+	hist_RecordSelect(0,triCount * TRI_VERT_COUNT,false);
+	
+	memset(selVerts,0,triCount * TRI_VERT_COUNT * sizeof(unsigned char));
 	selVertCount = 0;
 	
 	modified = true;
@@ -704,8 +1167,21 @@ void vertLayer::nearVert_SetColor(unsigned char color){
 		return;
 	}
 	
+	if(VERT_COLOR(&buffer,nearVert) == color){
+		return;
+	}
+	
+	struct histRecord rec;
+	
+	rec.target = this;
+	rec.op = HIST_COLOR;
+	rec.indices.push_back(nearVert);
+	rec.values.push_back(VERT_COLOR(&buffer,nearVert));
+	
+	hist::record(rec);
+	
+	meshWrite(nearVert / TRI_VERT_COUNT,nearVert / TRI_VERT_COUNT + 1);
 	VERT_COLOR(&buffer,nearVert) = color;
-	modified = true;
 }
 
 void vertLayer::nearVert_SetBone(unsigned char bone){
@@ -713,27 +1189,90 @@ void vertLayer::nearVert_SetBone(unsigned char bone){
 		return;
 	}
 	
+	if(VERT_BONE(&buffer,nearVert) == bone){
+		return;
+	}
+	
+	struct histRecord rec;
+	
+	rec.target = this;
+	rec.op = HIST_BONE;
+	rec.indices.push_back(nearVert);
+	rec.values.push_back(VERT_BONE(&buffer,nearVert));
+	
+	hist::record(rec);
+	
+	meshWrite(nearVert / TRI_VERT_COUNT,nearVert / TRI_VERT_COUNT + 1);
 	VERT_BONE(&buffer,nearVert) = bone;
-	modified = true;
 }
 
-void vertLayer::nearTri_Delete(){
-	if(!NEARTRI_VALID()){
+void vertLayer::brush_SetColor(int16_t x,int16_t y,unsigned int radius,bool selectedOnly,unsigned char color){
+	brush_Paint(x,y,radius,selectedOnly,HIST_COLOR,color);
+}
+
+void vertLayer::brush_SetBone(int16_t x,int16_t y,unsigned int radius,bool selectedOnly,unsigned char bone){
+	brush_Paint(x,y,radius,selectedOnly,HIST_BONE,bone);
+}
+
+void vertLayer::brush_Paint(int16_t x,int16_t y,unsigned int radius,bool selectedOnly,enum histOp op,unsigned char value){
+	if(!visible() || triCount == 0){
 		return;
 	}
 	
-	// Copying triangle from the end to nearest triangle, effectively replacing it
-	--buffer.count;
+	// Rest positions, as drawn in the color and bone states
+	brushQuery(buffer.xy,triCount * TRI_VERT_COUNT,x,y,radius,brushHits);
+	
+	// Vertices to change, with their current values for history
+	uint32_t firstTri = UINT32_MAX,endTri = 0;
+	
+	struct histRecord rec;
 	
-	copyTri(&buffer,buffer.count,&buffer,nearTri);
+	rec.target = this;
+	rec.op = op;
+	
+	for(std::vector<uint32_t>::iterator it = brushHits.begin();it != brushHits.end();++it){
+		uint8_t current = op == HIST_COLOR ? VERT_COLOR(&buffer,*it) : VERT_BONE(&buffer,*it);
+		
+		if(current == value || (selectedOnly && !selVerts[*it])){
+			continue;
+		}
+		
+		rec.indices.push_back(*it);
+		rec.values.push_back(current);
+		
+		firstTri = *it / TRI_VERT_COUNT < firstTri ? *it / TRI_VERT_COUNT : firstTri;
+		endTri = *it / TRI_VERT_COUNT + 1;
+	}
+	
+	if(rec.indices.empty()){
+		return;
+	}
+	
+	// Single pass over the hits, after the mesh is owned
+	meshWrite(firstTri,endTri);
+	
+	for(std::vector<uint32_t>::iterator it = rec.indices.begin();it != rec.indices.end();++it){
+		*(op == HIST_COLOR ? &VERT_COLOR(&buffer,*it) : &VERT_BONE(&buffer,*it)) = value;
+	}
+	
+	hist::record(rec);
+}
+
+void vertLayer::tri_Delete(unsigned int t){
+	meshWrite();
+	
+	// Copying triangle from the end to the given triangle, effectively replacing it
+	--triCount;
+	
+	copyTri(&buffer,triCount,&buffer,t);
 	
 	// Updating vertex selections
 	for(unsigned int i = 0;i < TRI_VERT_COUNT;++i){
-		if(selVerts[TRI_V(nearTri,i)]){
+		if(selVerts[TRI_V(t,i)]){
 			--selVertCount;
 		}
 		
-		selVerts[TRI_V(nearTri,i)] = selVerts[TRI_V(buffer.count,i)];
+		selVerts[TRI_V(t,i)] = selVerts[TRI_V(triCount,i)];
 	}
 	
 	// Updating state
@@ -743,25 +1282,58 @@ void vertLayer::nearTri_Delete(){
 	nearestPoint_Clear();
 }
 
+void vertLayer::nearTri_Delete(){
+	if(!NEARTRI_VALID()){
+		return;
+	}
+	
+	struct histRecord rec;
+	
+	rec.target = this;
+	rec.op = HIST_TRI_DELETE;
+	rec.index = nearTri;
+	rec.count = 1;
+	
+	rec.values.resize(LAYER_HIST_TRI_VALUE_COUNT);
+	tri_Pack(nearTri,&rec.values[0]);
+	
+	hist::record(rec);
+	
+	tri_Delete(nearTri);
+}
+
+void vertLayer::tris_Reserve(uint32_t count){
+	grow(count);
+}
+
 void vertLayer::tris_Add(int16_t x0,int16_t y0,int16_t x1,int16_t y1,int16_t x2,int16_t y2,unsigned char type){
-	if(buffer.count >= maxTris){
+	int16_t xy[TRI_XY_VALUE_COUNT] = {x0,y0,x1,y1,x2,y2};
+	
+	tris_Append(xy,1,type);
+}
+
+void vertLayer::tris_Append(const int16_t *xy,uint32_t count,unsigned char type){
+	if(count == 0 || count > UINT32_MAX / TRI_XY_VALUE_COUNT - triCount){
 		return;
 	}
 	
-	// Coordinates
-	VERT_X(&buffer,TRI_V(buffer.count,0)) = x0;
-	VERT_Y(&buffer,TRI_V(buffer.count,0)) = y0;
+	grow(triCount + count);
+	meshWrite();
+	
+	struct histRecord rec;
+	
+	rec.target = this;
+	rec.op = HIST_TRI_APPEND;
+	rec.index = triCount;
+	rec.count = count;
 	
-	VERT_X(&buffer,TRI_V(buffer.count,1)) = x1;
-	VERT_Y(&buffer,TRI_V(buffer.count,1)) = y1;
+	hist::record(rec);
 	
-	VERT_X(&buffer,TRI_V(buffer.count,2)) = x2;
-	VERT_Y(&buffer,TRI_V(buffer.count,2)) = y2;
+	// Coordinates
+	memcpy(buffer.xy + triCount * TRI_XY_VALUE_COUNT,xy,count * TRI_XY_VALUE_COUNT * sizeof(int16_t));
 	
 	// Other uniform data
-	for(unsigned int i = 0;i < TRI_VERT_COUNT;++i){
-		unsigned int j = TRI_V(buffer.count,i);
-		
+	for(unsigned int j = TRI_V(triCount,0);j < TRI_V(triCount + count,0);++j){
 		VERT_U(&buffer,j) = norm16_StoU(VERT_X(&buffer,j));
 		VERT_V(&buffer,j) = norm16_StoU(VERT_Y(&buffer,j));
 		
@@ -771,13 +1343,192 @@ void vertLayer::tris_Add(int16_t x0,int16_t y0,int16_t x1,int16_t y1,int16_t x2,
 	}
 	
 	// Selection clearance
-	selVerts[TRI_V(buffer.count,0)] = 0;
-	selVerts[TRI_V(buffer.count,1)] = 0;
-	selVerts[TRI_V(buffer.count,2)] = 0;
+	memset(selVerts + TRI_V(triCount,0),0,count * TRI_VERT_COUNT * sizeof(unsigned char));
 	
 	// Update state
-	++buffer.count;
+	triCount += count;
+	modified = true;
+}
+
+// History -------------------------------------------------------------------------------------------------------------------------------------------
+void vertLayer::tri_Pack(unsigned int t,uint16_t *out){
+	for(unsigned int i = 0;i < TRI_XY_VALUE_COUNT;++i){
+		*(out++) = buffer.xy[t * TRI_XY_VALUE_COUNT + i];
+	}
+	
+	for(unsigned int i = 0;i < TRI_UV_VALUE_COUNT;++i){
+		*(out++) = buffer.uv[t * TRI_UV_VALUE_COUNT + i];
+	}
+	
+	for(unsigned int i = 0;i < TRI_TBC_VALUE_COUNT;++i){
+		*(out++) = buffer.tbc[t * TRI_TBC_VALUE_COUNT + i];
+	}
+	
+	for(unsigned int i = 0;i < TRI_VERT_COUNT;++i){
+		*(out++) = selVerts[TRI_V(t,i)];
+	}
+}
+
+void vertLayer::tri_Unpack(unsigned int t,const uint16_t *in){
+	for(unsigned int i = 0;i < TRI_XY_VALUE_COUNT;++i){
+		buffer.xy[t * TRI_XY_VALUE_COUNT + i] = *(in++);
+	}
+	
+	for(unsigned int i = 0;i < TRI_UV_VALUE_COUNT;++i){
+		buffer.uv[t * TRI_UV_VALUE_COUNT + i] = *(in++);
+	}
+	
+	for(unsigned int i = 0;i < TRI_TBC_VALUE_COUNT;++i){
+		buffer.tbc[t * TRI_TBC_VALUE_COUNT + i] = *(in++);
+	}
+	
+	for(unsigned int i = 0;i < TRI_VERT_COUNT;++i){
+		selVerts[TRI_V(t,i)] = *(in++);
+		
+		if(selVerts[TRI_V(t,i)]){
+			++selVertCount;
+		}
+	}
+}
+
+void vertLayer::hist_RecordSelect(unsigned int first,unsigned int count,bool newState){
+	// Bit-packed difference, only nonzero words kept
+	struct histRecord rec;
+	
+	rec.target = this;
+	rec.op = HIST_SEL;
+	
+	uint64_t word = 0;
+	unsigned int wordIndex = first / 64;
+	
+	for(unsigned int i = first;i < first + count;++i){
+		if(i / 64 != wordIndex){
+			if(word != 0){
+				rec.indices.push_back(wordIndex);
+				rec.bits.push_back(word);
+			}
+			
+			word = 0;
+			wordIndex = i / 64;
+		}
+		
+		if((selVerts[i] != 0) != newState){
+			word |= (uint64_t)1 << (i % 64);
+		}
+	}
+	
+	if(word != 0){
+		rec.indices.push_back(wordIndex);
+		rec.bits.push_back(word);
+	}
+	
+	if(!rec.indices.empty()){
+		hist::record(rec);
+	}
+}
+
+void vertLayer::hist_Apply(struct histRecord &rec,bool undo){
+	uint16_t swapped;
+	
+	// Anything but the selection diverges linked layers
+	if(rec.op != HIST_SEL){
+		meshWrite();
+	}
+	
+	switch(rec.op){
+		case HIST_XY:
+		case HIST_UV:
+			for(unsigned int k = 0;k < rec.indices.size();++k){
+				uint16_t *vert = rec.op == HIST_UV ? &VERT_U(&buffer,rec.indices[k]) : (uint16_t *)&VERT_X(&buffer,rec.indices[k]);
+				
+				swapped = vert[0];
+				vert[0] = rec.values[k * 2 + 0];
+				rec.values[k * 2 + 0] = swapped;
+				
+				swapped = vert[1];
+				vert[1] = rec.values[k * 2 + 1];
+				rec.values[k * 2 + 1] = swapped;
+			}
+			
+			break;
+		case HIST_COLOR:
+		case HIST_BONE:
+			for(unsigned int k = 0;k < rec.indices.size();++k){
+				uint8_t *val = rec.op == HIST_COLOR ? &VERT_COLOR(&buffer,rec.indices[k]) : &VERT_BONE(&buffer,rec.indices[k]);
+				
+				swapped = *val;
+				*val = rec.values[k];
+				rec.values[k] = swapped;
+			}
+			
+			break;
+		case HIST_SEL:
+			for(unsigned int k = 0;k < rec.indices.size();++k){
+				uint64_t word = rec.bits[k];
+				
+				for(unsigned int i = rec.indices[k] * 64;word != 0;++i,word >>= 1){
+					if(!(word & 1)){
+						continue;
+					}
+					
+					selVerts[i] = !selVerts[i];
+					selVertCount += selVerts[i] ? 1 : -1;
+				}
+			}
+			
+			break;
+		case HIST_TRI_DELETE:
+			if(undo){
+				// The triangle moved into the gap goes back to the end
+				grow(triCount + 1);
+				
+				if(rec.index != triCount){
+					copyTri(&buffer,rec.index,&buffer,triCount);
+					
+					for(unsigned int i = 0;i < TRI_VERT_COUNT;++i){
+						selVerts[TRI_V(triCount,i)] = selVerts[TRI_V(rec.index,i)];
+					}
+				}
+				
+				tri_Unpack(rec.index,&rec.values[0]);
+				++triCount;
+			}else{
+				tri_Delete(rec.index);
+			}
+			
+			break;
+		case HIST_TRI_APPEND:
+			if(undo){
+				// Appended triangles are kept by the record, to be appended again
+				rec.values.resize(rec.count * LAYER_HIST_TRI_VALUE_COUNT);
+				
+				for(unsigned int t = 0;t < rec.count;++t){
+					tri_Pack(rec.index + t,&rec.values[t * LAYER_HIST_TRI_VALUE_COUNT]);
+					
+					for(unsigned int i = 0;i < TRI_VERT_COUNT;++i){
+						if(selVerts[TRI_V(rec.index + t,i)]){
+							--selVertCount;
+						}
+					}
+				}
+				
+				triCount = rec.index;
+			}else{
+				grow(rec.index + rec.count);
+				
+				for(unsigned int t = 0;t < rec.count;++t){
+					tri_Unpack(rec.index + t,&rec.values[t * LAYER_HIST_TRI_VALUE_COUNT]);
+				}
+				
+				triCount = rec.index + rec.count;
+				std::vector<uint16_t>().swap(rec.values);
+			}
+			
+			break;
+	}
+	
 	modified = true;
+	nearestPoint_Clear();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -872,10 +1623,5 @@ void gridLayer::draw(){
 		return;
 	}
 	
-	double unit = 2.0 / ((double)divisions + 1.0);
-	
-	for(unsigned int i = 0;i < (unsigned int)divisions + 2;++i){
-		hud::drawLine(hud::LINE_VERTICAL,vw::norm::toI(-1.0 + unit * (double)i),0,vw::norm::getZoomScale(),clr::get(clr::PFL_EDITR,CLR_EDITR_OFFWHITE,clr::ALF_BUTL));
-		hud::drawLine(hud::LINE_HORIZONTAL,0,vw::norm::toI(-1.0 + unit * (double)i),vw::norm::getZoomScale(),clr::get(clr::PFL_EDITR,CLR_EDITR_OFFWHITE,clr::ALF_BUTL));
-	}
+	hud::drawGrid(divisions,clr::get(clr::PFL_EDITR,CLR_EDITR_OFFWHITE,clr::ALF_BUTL));
 }
\ No newline at end of file
@@ -28,6 +28,11 @@ extern "C" {
 #include "triConstruct.hpp"
 #include "transformOp.hpp"
 #include "skeleton.hpp"
+#include "uniformState.hpp"
+#include "animation.hpp"
+#include "poseLibrary.hpp"
+#include "inverseKinematics.hpp"
+#include "history.hpp"
 
 enum keyInput{
 	KEY_ESC,
@@ -58,6 +63,8 @@ enum keyInput{
 	KEY_N,
 	KEY_Q,
 	KEY_S,
+	KEY_Y,
+	KEY_Z,
 	
 	KEY_PIPE,
 	KEY_PERIOD,
@@ -116,6 +123,10 @@ enum keyInput inputToKeySymbol(sf::Keyboard::Key key){
 			return KEY_Q;
 		case sf::Keyboard::S:
 			return KEY_S;
+		case sf::Keyboard::Y:
+			return KEY_Y;
+		case sf::Keyboard::Z:
+			return KEY_Z;
 		case sf::Keyboard::Backslash:
 			return KEY_PIPE;
 		case sf::Keyboard::Period:
@@ -128,6 +139,8 @@ enum keyInput inputToKeySymbol(sf::Keyboard::Key key){
 #define WIN_INIT_WIDTH 800
 #define WIN_INIT_HEIGHT 600
 
+#define LOAD_POLL_INTERVAL_MS 10
+
 unsigned int winWidth,winHeight,maxDim;
 
 void rescaleInnerViews(unsigned int newWidth,unsigned int newHeight){
@@ -155,12 +168,25 @@ bool currLayerValid(){
 	return currLayer < layers.size();
 }
 
+bool poseSlotParse(const char *str,unsigned int *slot){
+	char *end;
+	unsigned long value = strtoul(str,&end,10);
+	
+	if(end == str || *end != '\0' || value >= POSE_LIBRARY_SLOT_COUNT){
+		return false;
+	}
+	
+	*slot = value;
+	
+	return true;
+}
+
 int main(){
 	// Window --------------------------------------------
 	sf::ContextSettings glSettings;
 	glSettings.depthBits = 24;
 	glSettings.stencilBits = 8;
-	glSettings.antialiasingLevel = 4;
+	glSettings.antialiasingLevel = 0;
 	glSettings.majorVersion = 3;
 	glSettings.minorVersion = 3;
 	
@@ -222,6 +248,7 @@ int main(){
 	int statelessKI;
 	
 	bool selState,selActive = false;
+	bool brushActive = false;
 	
 	sf::Vector2<int32_t> tempPos;
 	
@@ -232,44 +259,104 @@ int main(){
 	char commandFeedback[STRIN_MAX_LEN + 40];
 	bool commandFeedbackDisp = false;
 	
+	char refSource[STRIN_MAX_LEN + 1],texSource[STRIN_MAX_LEN + 1];
+	unsigned int loadPercent;
+	bool loading = false;
+	
 	// Loop & Loop State -----------------------------------
 	bool run = true;
 	sf::Event event;
 	
 	while(window.isOpen() && run){
-		// Drawing -------------------------------------
-		window.clear();
+		// Asynchronous loading --------------------------
+		loading = render::tex::update();
+		loading = hud::ref::update() || loading;
 		
-		// Content render
-		if(state::getDraw() == D_STATE_UV){
-			render::tex::draw();
-		}else{
-			hud::ref::draw();
+		switch(hud::ref::loadStatus(&loadPercent)){
+			case graphics::LOAD_BUSY:
+				sprintf(commandFeedback,"Loading reference from \'%s\'... %3u%%",refSource,loadPercent);
+				
+				break;
+			case graphics::LOAD_SUCCEEDED:
+				snprintf(commandFeedback,sizeof(commandFeedback),"Loaded reference from \'%s\'%s",refSource,hud::ref::storeNote());
+				commandFeedbackDisp = true;
+				
+				break;
+			case graphics::LOAD_FAILED:
+				sprintf(commandFeedback,"Unable to load reference from \'%s\'",refSource);
+				commandFeedbackDisp = true;
+				
+				break;
+			default:
+				break;
+		}
+		
+		switch(render::tex::loadStatus(&loadPercent)){
+			case graphics::LOAD_BUSY:
+				sprintf(commandFeedback,"Loading texture from \'%s\'... %3u%%",texSource,loadPercent);
+				
+				break;
+			case graphics::LOAD_SUCCEEDED:
+				sprintf(commandFeedback,"Loaded texture from \'%s\'",texSource);
+				commandFeedbackDisp = true;
+				
+				break;
+			case graphics::LOAD_FAILED:
+				sprintf(commandFeedback,"Unable to load texture from \'%s\'",texSource);
+				commandFeedbackDisp = true;
+				
+				break;
+			default:
+				break;
 		}
 		
-		hud::drawCenter();
+		// Animation playback --------------------------
+		if(anim::update()){
+			render::scene::invalidate();
+		}
 		
-		grid.draw();
+		// Inverse kinematics, resumed each frame within its budget
+		if(ik::solve()){
+			render::scene::invalidate();
+		}
 		
-		for(std::vector<class vertLayer *>::iterator it = layers.begin();it != layers.end();++it){
-			if(layers.begin() + currLayer == it){
-				(*it)->draw(currBone,wireframe,true);
+		// Drawing -------------------------------------
+		window.clear();
+		
+		// Content render, cached until an event changes it
+		if(render::scene::begin()){
+			if(state::getDraw() == D_STATE_UV){
+				render::tex::draw();
+			}else{
+				hud::ref::draw();
+			}
+			
+			hud::drawCenter();
+			
+			grid.draw();
+			
+			for(std::vector<class vertLayer *>::iterator it = layers.begin();it != layers.end();++it){
+				(*it)->draw(currBone,wireframe);
 				
-				if(state::get() == STATE_ATOP_TRI_ADD){
+				if(layers.begin() + currLayer == it && state::get() == STATE_ATOP_TRI_ADD){
 					triCn::drawPreview(wireframe);
 				}
-			}else{
-				(*it)->draw(currBone,wireframe,false);
 			}
+			
+			if(state::get() == STATE_BONES || state::get() == STATE_ATOP_BONE_PARENT_SET){
+				bones::draw();
+			}else if(state::get() == STATE_POSE || state::get() == STATE_ATOP_TRANSFORM_POSE || state::get() == STATE_ATOP_IK_POSE){
+				pose::draw();
+			}
+			
+			render::scene::end(window);
 		}
 		
-		if(state::get() == STATE_BONES || state::get() == STATE_ATOP_BONE_PARENT_SET){
-			bones::draw();
-		}else if(state::get() == STATE_POSE || state::get() == STATE_ATOP_TRANSFORM_POSE){
-			pose::draw();
+		// HUD
+		if(currLayerValid()){
+			layers[currLayer]->drawNearestPoint();
 		}
 		
-		// HUD
 		trOp::drawUI();
 		
 		hud::drawCircleOutline(mX,mY,true,vw::norm::seekRadius(),clr::get(clr::PFL_EDITR,CLR_EDITR_HICONTRAST,clr::ALF_HALF));
@@ -284,7 +371,7 @@ int main(){
 		switch(state::get()){
 			case STATE_VERT_COLOR:
 			case STATE_ATOP_COLOR_SET:
-				hud::drawCustomColorsRef(currClr,state::get() == STATE_ATOP_COLOR_SET ? strIn::buffer() : NULL);
+				hud::drawCustomColorsRef(currLayerValid() ? layers[currLayer]->paletteGet() : 0,currClr,state::get() == STATE_ATOP_COLOR_SET ? strIn::buffer() : NULL);
 				
 				break;
 			case STATE_VERT_BONE:
@@ -330,14 +417,26 @@ int main(){
 		hud::drawStateState(state::get());
 		
 		// Done
+		hud::flush();
 		window.display();
 		
+		// Tiles requested by this frame's reference draw, animation frames, and unsettled solves
+		loading = hud::ref::streaming() || anim::playing() || ik::solving() || loading;
+		
 		// Event Handling --------------------------------
-		if(window.waitEvent(event)){
+		// Keep redrawing while loads are in flight, otherwise block on input
+		if(loading && !window.pollEvent(event)){
+			sf::sleep(sf::milliseconds(LOAD_POLL_INTERVAL_MS));
+		}else if(loading || window.waitEvent(event)){
 			isCtrlDown = sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) || sf::Keyboard::isKeyPressed(sf::Keyboard::RControl);
 			isAltDown = sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt) || sf::Keyboard::isKeyPressed(sf::Keyboard::RAlt);
 			isShiftDown = sf::Keyboard::isKeyPressed(sf::Keyboard::LShift) || sf::Keyboard::isKeyPressed(sf::Keyboard::RShift);
 			
+			// Cursor-only movement leaves the scene intact, anything else may change it
+			if(event.type != sf::Event::MouseMoved){
+				render::scene::invalidate();
+			}
+			
 			switch(event.type){
 				case sf::Event::Closed:
 					run = false;
@@ -391,6 +490,14 @@ int main(){
 									(*it)->nearestPoint_Clear();
 								}
 								
+								break;
+							case STATELESS_KI(1,0,0,KEY_Z):
+								hist::undo();
+								
+								break;
+							case STATELESS_KI(1,0,0,KEY_Y):
+								hist::redo();
+								
 								break;
 							default:
 								break;
@@ -504,7 +611,7 @@ int main(){
 							{
 								struct vertLayer *newLayer = new vertLayer(100,NULL,NULL);
 								newLayer->nameSet("layer");
-								newLayer->vertModifiers_Set((&trOp::apply),(&trOp::dirty));
+								newLayer->vertModifiers_Set((&trOp::apply),(&trOp::applyBatch),(&trOp::dirty));
 								
 								if(layers.empty()){
 									layers.insert(layers.begin(),newLayer);
@@ -530,6 +637,15 @@ int main(){
 								currLayer = layers.size() - 1;
 							}
 							
+							break;
+						case STATED_KI(STATE_LAYERS,0,1,0,KEY_C):
+							if(!currLayerValid()){
+								break;
+							}
+							
+							// Duplicate above the current layer
+							layers.insert(layers.begin() + currLayer + 1,new vertLayer(layers[currLayer]));
+							
 							break;
 						case STATED_KI(STATE_LAYERS,0,1,0,KEY_G):
 							strIn::activate(4);
@@ -596,6 +712,12 @@ int main(){
 							
 							state::set(STATE_POSE);
 							
+							break;
+						case STATED_KI(STATE_ATOP_IK_POSE,0,0,0,KEY_ESC):
+							ik::cancel();
+							
+							state::set(STATE_POSE);
+							
 							break;
 						default:
 							break;
@@ -626,9 +748,10 @@ int main(){
 										sprintf(commandFeedback,"Reference source needed");
 									}else{
 										if(hud::ref::load(commandStr)){
-											sprintf(commandFeedback,"Loaded reference from \'%s\'",commandStr);
+											strcpy(refSource,commandStr);
+											sprintf(commandFeedback,"Loading reference from \'%s\'...",refSource);
 										}else{
-											sprintf(commandFeedback,"Unable to load reference from \'%s\'",commandStr);
+											sprintf(commandFeedback,"Reference load already in progress");
 										}
 									}
 								}else if(strcmp(commandStr,"unloadref") == 0){
@@ -644,9 +767,10 @@ int main(){
 										sprintf(commandFeedback,"Texture source needed");
 									}else{
 										if(render::tex::load(commandStr)){
-											sprintf(commandFeedback,"Loaded texture from \'%s\'",commandStr);
+											strcpy(texSource,commandStr);
+											sprintf(commandFeedback,"Loading texture from \'%s\'...",texSource);
 										}else{
-											sprintf(commandFeedback,"Unable to load texture from \'%s\'",commandStr);
+											sprintf(commandFeedback,"Texture load already in progress");
 										}
 									}
 								}else if(strcmp(commandStr,"unloadtex") == 0){
@@ -674,7 +798,7 @@ int main(){
 												sprintf(commandFeedback,"Error reading layer from \'%s\'",commandStr);
 											}else{
 												newLayer->nameSet(commandStr);
-												newLayer->vertModifiers_Set((&trOp::apply),(&trOp::dirty));
+												newLayer->vertModifiers_Set((&trOp::apply),(&trOp::applyBatch),(&trOp::dirty));
 												layers.insert(layers.begin() + currLayer,newLayer);
 												
 												sprintf(commandFeedback,"Layer read from \'%s\'",commandStr);
@@ -710,6 +834,238 @@ int main(){
 										}
 									}
 									
+								}else if(strcmp(commandStr,"palette") == 0){
+									// Layer color palette -----------------------------------
+									commandStr = strtok(NULL," ");
+									
+									if(!currLayerValid()){
+										sprintf(commandFeedback,"No layer for palette selection");
+									}else if(commandStr == NULL){
+										sprintf(commandFeedback,"Layer uses palette %u",layers[currLayer]->paletteGet());
+									}else if(strtoul(commandStr,NULL,10) >= CLR_CSTM_PALETTE_COUNT){
+										sprintf(commandFeedback,"Palette must be below %u",CLR_CSTM_PALETTE_COUNT);
+									}else{
+										layers[currLayer]->paletteSet(strtoul(commandStr,NULL,10));
+										sprintf(commandFeedback,"Layer now uses palette %u",layers[currLayer]->paletteGet());
+									}
+									
+								}else if(strcmp(commandStr,"layeroffset") == 0){
+									// Layer instance placement in view -----------------------------------
+									char *xStr = strtok(NULL," ");
+									char *yStr = strtok(NULL," ");
+									
+									if(!currLayerValid()){
+										sprintf(commandFeedback,"No layer to offset");
+									}else{
+										if(xStr != NULL && yStr != NULL){
+											layers[currLayer]->offsetSet(vw::norm::toI(strtod(xStr,NULL)),vw::norm::toI(strtod(yStr,NULL)));
+											render::scene::invalidate();
+										}
+										
+										sprintf(commandFeedback,"%s layer offset by %.3f,%.3f",
+											layers[currLayer]->linked() ? "Linked" : "Unlinked",
+											vw::norm::toD(layers[currLayer]->offsetGetX()),
+											vw::norm::toD(layers[currLayer]->offsetGetY())
+										);
+									}
+									
+								}else if(strcmp(commandStr,"key") == 0){
+									// Animation keyframes -----------------------------------
+									anim::key(currBone);
+									sprintf(commandFeedback,"Keyed bone %u at frame %u",currBone,anim::frame());
+									
+								}else if(strcmp(commandStr,"unkey") == 0){
+									if(anim::unkey(currBone)){
+										sprintf(commandFeedback,"Unkeyed bone %u at frame %u",currBone,anim::frame());
+									}else{
+										sprintf(commandFeedback,"No key for bone %u at frame %u",currBone,anim::frame());
+									}
+									
+								}else if(strcmp(commandStr,"frame") == 0){
+									// Animation timeline -----------------------------------
+									commandStr = strtok(NULL," ");
+									
+									if(commandStr != NULL){
+										anim::seek(strtoul(commandStr,NULL,10));
+									}
+									
+									sprintf(commandFeedback,"Frame %u of %u",anim::frame(),anim::length());
+									
+								}else if(strcmp(commandStr,"length") == 0){
+									commandStr = strtok(NULL," ");
+									
+									if(commandStr != NULL){
+										anim::setLength(strtoul(commandStr,NULL,10));
+									}
+									
+									sprintf(commandFeedback,"Animation length %u frames at %u fps",anim::length(),ANIM_FRAME_RATE);
+									
+								}else if(strcmp(commandStr,"play") == 0){
+									// Animation playback -----------------------------------
+									anim::play();
+									sprintf(commandFeedback,"Playing %u keys over %u frames",anim::keyCount(),anim::length());
+									
+								}else if(strcmp(commandStr,"stop") == 0){
+									anim::stop();
+									sprintf(commandFeedback,"Stopped at frame %u",anim::frame());
+									
+								}else if(strcmp(commandStr,"exportanim") == 0){
+									// Baked animation export -----------------------------------
+									commandStr = strtok(NULL," ");
+									
+									if(commandStr == NULL){
+										sprintf(commandFeedback,"Animation destination needed");
+									}else{
+										FILE *out = fopen(commandStr,"wb");
+										
+										if(out == NULL){
+											sprintf(commandFeedback,"Unable to open \'%s\' for writing",commandStr);
+										}else{
+											if(anim::exportBaked(out)){
+												sprintf(commandFeedback,"Animation baked to \'%s\'",commandStr);
+											}else{
+												sprintf(commandFeedback,"Error baking animation to \'%s\'",commandStr);
+											}
+											
+											fclose(out);
+										}
+									}
+									
+								}else if(strcmp(commandStr,"posesave") == 0){
+									// Pose library -----------------------------------
+									commandStr = strtok(NULL," ");
+									
+									unsigned int slot;
+									
+									if(commandStr == NULL){
+										sprintf(commandFeedback,"Pose slot needed");
+									}else if(!poseSlotParse(commandStr,&slot)){
+										sprintf(commandFeedback,"Pose slot must be a number below %u",POSE_LIBRARY_SLOT_COUNT);
+									}else{
+										poseLib::store(slot,strtok(NULL," "));
+										
+										sprintf(commandFeedback,"Pose stored in slot %u \'%s\'",slot,poseLib::name(slot));
+									}
+									
+								}else if(strcmp(commandStr,"poseload") == 0){
+									commandStr = strtok(NULL," ");
+									
+									unsigned int slot;
+									
+									if(commandStr == NULL){
+										sprintf(commandFeedback,"Pose slot needed");
+									}else if(!poseSlotParse(commandStr,&slot)){
+										sprintf(commandFeedback,"Pose slot must be a number below %u",POSE_LIBRARY_SLOT_COUNT);
+									}else{
+										if(poseLib::recall(slot)){
+											sprintf(commandFeedback,"Pose recalled from slot %u \'%s\'",slot,poseLib::name(slot));
+										}else{
+											sprintf(commandFeedback,"Pose slot %u is empty",slot);
+										}
+									}
+									
+								}else if(strcmp(commandStr,"poseblend") == 0){
+									char *slotAStr = strtok(NULL," ");
+									char *slotBStr = strtok(NULL," ");
+									char *weightStr = strtok(NULL," ");
+									
+									unsigned int slotA,slotB;
+									
+									float weight = 0.5;
+									char *weightEnd = NULL;
+									
+									if(weightStr != NULL){
+										weight = strtof(weightStr,&weightEnd);
+									}
+									
+									if(slotAStr == NULL || slotBStr == NULL){
+										sprintf(commandFeedback,"Two pose slots needed");
+									}else if(!poseSlotParse(slotAStr,&slotA) || !poseSlotParse(slotBStr,&slotB)){
+										sprintf(commandFeedback,"Pose slots must be numbers below %u",POSE_LIBRARY_SLOT_COUNT);
+									}else if(weightStr != NULL && (weightEnd == weightStr || *weightEnd != '\0' || !(weight >= 0.0 && weight <= 1.0))){
+										sprintf(commandFeedback,"Blend weight must be a number from 0 to 1");
+									}else{
+										if(poseLib::blend(slotA,slotB,weight)){
+											sprintf(commandFeedback,"Poses %u and %u blended at %.2f",slotA,slotB,weight);
+										}else{
+											sprintf(commandFeedback,"Pose slots %u and %u must both be stored",slotA,slotB);
+										}
+									}
+									
+								}else if(strcmp(commandStr,"readposes") == 0){
+									commandStr = strtok(NULL," ");
+									
+									if(commandStr == NULL){
+										sprintf(commandFeedback,"Pose library source needed");
+									}else{
+										FILE *in = fopen(commandStr,"rb");
+										
+										if(in == NULL){
+											sprintf(commandFeedback,"Unable to open \'%s\' for reading",commandStr);
+										}else{
+											if(poseLib::read(in)){
+												sprintf(commandFeedback,"Pose library read from \'%s\'",commandStr);
+											}else{
+												sprintf(commandFeedback,"Error reading pose library from \'%s\'",commandStr);
+											}
+											
+											fclose(in);
+										}
+									}
+									
+								}else if(strcmp(commandStr,"writeposes") == 0){
+									commandStr = strtok(NULL," ");
+									
+									if(commandStr == NULL){
+										sprintf(commandFeedback,"Pose library destination needed");
+									}else{
+										FILE *out = fopen(commandStr,"wb");
+										
+										if(out == NULL){
+											sprintf(commandFeedback,"Unable to open \'%s\' for writing",commandStr);
+										}else{
+											if(poseLib::write(out)){
+												sprintf(commandFeedback,"Pose library written to \'%s\'",commandStr);
+											}else{
+												sprintf(commandFeedback,"Error writing pose library to \'%s\'",commandStr);
+											}
+											
+											fclose(out);
+										}
+									}
+									
+								}else if(strcmp(commandStr,"undobudget") == 0){
+									// Undo history -----------------------------------
+									commandStr = strtok(NULL," ");
+									
+									if(commandStr != NULL){
+										hist::budgetSet(strtoul(commandStr,NULL,10) * 1024 * 1024);
+									}
+									
+									sprintf(commandFeedback,"History: %u undoable, %u redoable, %.1f of %.1f MiB%s",
+										hist::undoable(),hist::redoable(),hist::used() / 1048576.0,hist::budget() / 1048576.0,
+										hist::budgetMet() ? "" : ", over budget as the latest step alone exceeds it"
+									);
+									
+								}else if(strcmp(commandStr,"skinbench") == 0){
+									// Skinning throughput -----------------------------------
+									commandStr = strtok(NULL," ");
+									
+									unsigned int vertCount = commandStr == NULL ? SKIN_BENCHMARK_DEFAULT_VERTS : strtoul(commandStr,NULL,10);
+									double runMVerts,mixedMVerts;
+									
+									if(vertCount == 0){
+										sprintf(commandFeedback,"Vertex count needed");
+									}else{
+										pose::skinBenchmark(vertCount,&runMVerts,&mixedMVerts);
+										sprintf(commandFeedback,"Skinning %u vertices: %.0f Mverts/s on bone runs, %.0f Mverts/s on mixed bones",vertCount,runMVerts,mixedMVerts);
+									}
+									
+								}else if(strcmp(commandStr,"stats") == 0){
+									// Uniform upload statistics -----------------------------------
+									sprintf(commandFeedback,"Uniform uploads: %lu issued, %lu skipped",unif::issued(),unif::skipped());
+									unif::statsReset();
+									
 								}else{
 									sprintf(commandFeedback,"Unknown command");
 								}
@@ -720,7 +1076,7 @@ int main(){
 							break;
 						case STATE_ATOP_COLOR_SET:
 							if(strIn::interpret(event.text.unicode)){
-								clrCstm::set(currClr,strtoul(strIn::buffer(),NULL,16));
+								clrCstm::set(currLayerValid() ? layers[currLayer]->paletteGet() : 0,currClr,strtoul(strIn::buffer(),NULL,16));
 								strIn::deactivate();
 								
 								state::set(STATE_VERT_COLOR);
@@ -830,13 +1186,29 @@ int main(){
 									
 									break;
 								case STATE_VERT_COLOR:
-									if(currLayerValid()){
+									brushActive = isAltDown;
+									
+									if(!currLayerValid()){
+										break;
+									}
+									
+									if(brushActive){
+										layers[currLayer]->brush_SetColor(mX,mY,vw::seekRadius(),isShiftDown,currClr);
+									}else{
 										layers[currLayer]->nearVert_SetColor(currClr);
 									}
 									
 									break;
 								case STATE_VERT_BONE:
-									if(currLayerValid()){
+									brushActive = isAltDown;
+									
+									if(!currLayerValid()){
+										break;
+									}
+									
+									if(brushActive){
+										layers[currLayer]->brush_SetBone(mX,mY,vw::seekRadius(),isShiftDown,currBone);
+									}else{
 										layers[currLayer]->nearVert_SetBone(currBone);
 									}
 									
@@ -865,6 +1237,11 @@ int main(){
 											if(trOp::init(TROP_SCALE,tempPos.x,tempPos.y)){
 												state::set(STATE_ATOP_TRANSFORM_POSE);
 											}
+										}else if(sf::Keyboard::isKeyPressed(sf::Keyboard::K)){
+											if(ik::begin(currBone)){
+												ik::target(iX,iY);
+												state::set(STATE_ATOP_IK_POSE);
+											}
 										}
 									}
 									
@@ -939,6 +1316,12 @@ int main(){
 											break;
 									}
 									
+									break;
+								case STATE_ATOP_IK_POSE:
+									ik::commit();
+									
+									state::set(STATE_POSE);
+									
 									break;
 								default:
 									break;
@@ -967,6 +1350,7 @@ int main(){
 					
 					if(sf::Mouse::isButtonPressed(sf::Mouse::Right)){
 						vw::panContinue();
+						render::scene::invalidate();
 					}
 					
 					// Snapping element & nearest point & mesh-space cursor position calculation
@@ -995,17 +1379,29 @@ int main(){
 					// Triangle constructor preview update
 					if(triCn::building()){
 						triCn::considerPoint(iX,iY);
+						render::scene::invalidate();
 					}
 					
 					// Tranformation operation preview update
 					trOp::update(iX,iY);
 					
+					if(trOp::dirty()){
+						render::scene::invalidate();
+					}
+					
 					if(state::get() == STATE_ATOP_TRANSFORM_POSE && trOp::dirty()){
 						pose::updateModifiers(false,currBone);
 					}
 					
+					// Inverse kinematics target, solved from the next frame onwards
+					if(state::get() == STATE_ATOP_IK_POSE){
+						ik::target(iX,iY);
+					}
+					
 					// Selection updates
 					if(sf::Mouse::isButtonPressed(sf::Mouse::Left) && currLayerValid()){
+						render::scene::invalidate();
+						
 						switch(state::get()){
 							case STATE_VERT_XY:
 								if(selActive){
@@ -1014,11 +1410,19 @@ int main(){
 								
 								break;
 							case STATE_VERT_COLOR:
-								layers[currLayer]->nearVert_SetColor(currClr);
+								if(brushActive){
+									layers[currLayer]->brush_SetColor(mX,mY,vw::seekRadius(),isShiftDown,currClr);
+								}else{
+									layers[currLayer]->nearVert_SetColor(currClr);
+								}
 								
 								break;
 							case STATE_VERT_BONE:
-								layers[currLayer]->nearVert_SetBone(currBone);
+								if(brushActive){
+									layers[currLayer]->brush_SetBone(mX,mY,vw::seekRadius(),isShiftDown,currBone);
+								}else{
+									layers[currLayer]->nearVert_SetBone(currBone);
+								}
 								
 								break;
 							default:
@@ -1031,6 +1435,7 @@ int main(){
 					switch(event.mouseButton.button){
 						case sf::Mouse::Left:
 							selActive = false;
+							brushActive = false;
 							
 							break;
 						case sf::Mouse::Right:
@@ -1046,6 +1451,11 @@ int main(){
 					break;
 			}
 			
+			// One history step per event, or per drag of the left button
+			if(!sf::Mouse::isButtonPressed(sf::Mouse::Left)){
+				hist::commit();
+			}
+			
 			pose::update();
 		}
 	}
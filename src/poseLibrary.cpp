@@ -0,0 +1,240 @@
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BLEND_SSE2
+	#include <emmintrin.h>
+#endif
+
+extern "C" {
+	#include <vecGL/bones.h>
+}
+
+#include "poseLibrary.hpp"
+#include "skeleton.hpp"
+#include "fileIO.hpp"
+
+// Slots are stored field by field across all bones, for blending four bones at a time
+struct poseSlot{
+	bool used;
+	char name[POSE_NAME_STRLEN + 1];
+	
+	float translateX[BONES_MAX_COUNT];
+	float translateY[BONES_MAX_COUNT];
+	float scale[BONES_MAX_COUNT];
+	float rotation[BONES_MAX_COUNT];
+};
+
+#define POSE_SLOT_FIELD_COUNT 4
+
+namespace poseLib{
+	struct poseSlot slots[POSE_LIBRARY_SLOT_COUNT];
+	
+	float *slotField(struct poseSlot *slot,unsigned int field){
+		switch(field){
+			case 0:
+				return slot->translateX;
+			case 1:
+				return slot->translateY;
+			case 2:
+				return slot->scale;
+			default:
+				return slot->rotation;
+		}
+	}
+	
+	// Slots ---------------------------------------------------
+	void store(unsigned int slot,const char *name){
+		struct poseSlot *s = &slots[slot % POSE_LIBRARY_SLOT_COUNT];
+		
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			int32_t tX,tY;
+			pose::getLocal(i,&tX,&tY,&(s->scale[i]),&(s->rotation[i]));
+			
+			s->translateX[i] = tX;
+			s->translateY[i] = tY;
+		}
+		
+		strncpy(s->name,name == NULL ? "" : name,POSE_NAME_STRLEN);
+		s->name[POSE_NAME_STRLEN] = '\0';
+		s->used = true;
+	}
+	
+	bool recall(unsigned int slot){
+		return blend(slot,slot,0.0);
+	}
+	
+	bool used(unsigned int slot){
+		return slots[slot % POSE_LIBRARY_SLOT_COUNT].used;
+	}
+	
+	const char *name(unsigned int slot){
+		return slots[slot % POSE_LIBRARY_SLOT_COUNT].name;
+	}
+	
+	// Blending ---------------------------------------------------
+	bool blend(const unsigned int *blended,const float *weights,unsigned int count){
+		for(unsigned int k = 0;k < count;++k){
+			if(!used(blended[k])){
+				return false;
+			}
+		}
+		
+		struct poseSlot result;
+		float weightSums[BONES_MAX_COUNT];
+		
+		memset(&result,0,sizeof(result));
+		memset(weightSums,0,sizeof(weightSums));
+		
+		// Weighted sums of every field, then normalization by each bone's total weight
+		for(unsigned int k = 0;k < count;++k){
+			struct poseSlot *s = &slots[blended[k] % POSE_LIBRARY_SLOT_COUNT];
+			const float *w = weights + k * BONES_MAX_COUNT;
+			
+			for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+				weightSums[i] += w[i];
+			}
+			
+			for(unsigned int f = 0;f < POSE_SLOT_FIELD_COUNT;++f){
+				float *src = slotField(s,f);
+				float *dst = slotField(&result,f);
+				unsigned int i = 0;
+				
+				#ifdef BLEND_SSE2
+				for(;i + 4 <= BONES_MAX_COUNT;i += 4){
+					_mm_storeu_ps(dst + i,_mm_add_ps(_mm_loadu_ps(dst + i),_mm_mul_ps(_mm_loadu_ps(src + i),_mm_loadu_ps(w + i))));
+				}
+				#endif
+				
+				for(;i < BONES_MAX_COUNT;++i){
+					dst[i] += src[i] * w[i];
+				}
+			}
+		}
+		
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			weightSums[i] = weightSums[i] > 0.0 ? 1.0 / weightSums[i] : 0.0;
+		}
+		
+		for(unsigned int f = 0;f < POSE_SLOT_FIELD_COUNT;++f){
+			float *dst = slotField(&result,f);
+			unsigned int i = 0;
+			
+			#ifdef BLEND_SSE2
+			for(;i + 4 <= BONES_MAX_COUNT;i += 4){
+				_mm_storeu_ps(dst + i,_mm_mul_ps(_mm_loadu_ps(dst + i),_mm_loadu_ps(weightSums + i)));
+			}
+			#endif
+			
+			for(;i < BONES_MAX_COUNT;++i){
+				dst[i] *= weightSums[i];
+			}
+		}
+		
+		// Into the live pose, bones without weight keeping their unit scale
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			pose::setLocal(
+				i,
+				(int32_t)roundf(result.translateX[i]),
+				(int32_t)roundf(result.translateY[i]),
+				weightSums[i] > 0.0 ? result.scale[i] : 1.0,
+				result.rotation[i]
+			);
+		}
+		
+		pose::update();
+		pose::edited();
+		
+		return true;
+	}
+	
+	bool blend(unsigned int slotA,unsigned int slotB,float t){
+		unsigned int blended[2] = {slotA,slotB};
+		float weights[2 * BONES_MAX_COUNT];
+		
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			weights[i] = 1.0 - t;
+			weights[BONES_MAX_COUNT + i] = t;
+		}
+		
+		return blend(blended,weights,2);
+	}
+	
+	// File I/O ---------------------------------------------------
+	bool writeFloat(float val,FILE *out){
+		uint32_t bits;
+		memcpy(&bits,&val,sizeof(bits));
+		
+		return fIO::u32::write(bits,out);
+	}
+	
+	bool readFloat(float *val,FILE *in){
+		uint32_t bits;
+		
+		if(!fIO::u32::read(&bits,in)){
+			return false;
+		}
+		
+		memcpy(val,&bits,sizeof(bits));
+		
+		return true;
+	}
+	
+	bool write(FILE *out){
+		bool success = fIO::u8::write(POSE_LIBRARY_SLOT_COUNT,out) && fIO::u8::write(BONES_MAX_COUNT,out);
+		
+		for(unsigned int k = 0;success && k < POSE_LIBRARY_SLOT_COUNT;++k){
+			success = fIO::u8::write(slots[k].used,out);
+			
+			for(unsigned int c = 0;success && c < POSE_NAME_STRLEN;++c){
+				success = fIO::u8::write(slots[k].name[c],out);
+			}
+			
+			for(unsigned int f = 0;success && f < POSE_SLOT_FIELD_COUNT;++f){
+				for(unsigned int i = 0;success && i < BONES_MAX_COUNT;++i){
+					success = writeFloat(slotField(&slots[k],f)[i],out);
+				}
+			}
+		}
+		
+		return success;
+	}
+	
+	bool read(FILE *in){
+		uint8_t slotCount,boneCount;
+		
+		if(!fIO::u8::read(&slotCount,in) || !fIO::u8::read(&boneCount,in) || slotCount != POSE_LIBRARY_SLOT_COUNT || boneCount != BONES_MAX_COUNT){
+			return false;
+		}
+		
+		// Read fully before replacing the library
+		struct poseSlot readSlots[POSE_LIBRARY_SLOT_COUNT];
+		bool success = true;
+		
+		for(unsigned int k = 0;success && k < POSE_LIBRARY_SLOT_COUNT;++k){
+			uint8_t val;
+			
+			success = fIO::u8::read(&val,in);
+			readSlots[k].used = val;
+			
+			for(unsigned int c = 0;success && c < POSE_NAME_STRLEN;++c){
+				success = fIO::u8::read(&val,in);
+				readSlots[k].name[c] = val;
+			}
+			
+			readSlots[k].name[POSE_NAME_STRLEN] = '\0';
+			
+			for(unsigned int f = 0;success && f < POSE_SLOT_FIELD_COUNT;++f){
+				for(unsigned int i = 0;success && i < BONES_MAX_COUNT;++i){
+					success = readFloat(&(slotField(&readSlots[k],f)[i]),in);
+				}
+			}
+		}
+		
+		if(success){
+			memcpy(slots,readSlots,sizeof(slots));
+		}
+		
+		return success;
+	}
+}
@@ -1,3 +1,11 @@
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SKIN_SSE2
+	#include <emmintrin.h>
+#endif
+
 extern "C" {
 	#include <vecGL/shader.h>
 	#include <vecGL/bones.h>
@@ -10,9 +18,14 @@ extern "C" {
 
 #define PI 3.14159265358979323846
 
+#define SKIN_BENCHMARK_MILLISECONDS 250
+
 bool poseBoneModified[BONES_MAX_COUNT];
 bool poseModified;
 
+// Bumped by any change to the skeleton or its live pose, save for animation sampling
+unsigned int skeletonRevision = 0;
+
 struct bone{
 	int16_t x,y;
 	unsigned char parent;
@@ -20,7 +33,38 @@ struct bone{
 
 struct bone boneArray[BONES_MAX_COUNT];
 
+// Hierarchy flattened in preorder: every bone precedes its subtree,
+// which occupies the next boneSubtreeSizes[bone] - 1 entries of boneOrder
+unsigned char boneOrder[BONES_MAX_COUNT];
+unsigned char boneSubtreeSizes[BONES_MAX_COUNT];
+
 namespace bones{
+	unsigned int orderSubtree(unsigned char root,unsigned int at){
+		unsigned int next = at + 1;
+		
+		boneOrder[at] = root;
+		
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			if(boneArray[i].parent == root){
+				next = orderSubtree(i,next);
+			}
+		}
+		
+		boneSubtreeSizes[root] = next - at;
+		
+		return next;
+	}
+	
+	void order(){
+		unsigned int at = 0;
+		
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			if(boneArray[i].parent >= BONES_MAX_COUNT){
+				at = orderSubtree(i,at);
+			}
+		}
+	}
+	
 	void init(){
 		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
 			boneArray[i].parent = BONES_MAX_COUNT;
@@ -28,7 +72,9 @@ namespace bones{
 			poseBoneModified[i] = true;
 		}
 		
+		order();
 		poseModified = true;
+		++skeletonRevision;
 	}
 	
 	void setOrigin(unsigned char i,int16_t x,int16_t y){
@@ -39,6 +85,7 @@ namespace bones{
 		
 		poseBoneModified[j] = true;
 		poseModified = true;
+		++skeletonRevision;
 	}
 	
 	void setParent(unsigned char i,unsigned char parent){
@@ -47,9 +94,11 @@ namespace bones{
 		// Escape case
 		if(parent >= BONES_MAX_COUNT){
 			boneArray[j].parent = BONES_MAX_COUNT;
+			order();
 			
 			poseBoneModified[j] = true;
 			poseModified = true;
+			++skeletonRevision;
 			
 			return;
 		}
@@ -71,9 +120,11 @@ namespace bones{
 		
 		// Assign
 		boneArray[j].parent = parent;
+		order();
 		
 		poseBoneModified[j] = true;
 		poseModified = true;
+		++skeletonRevision;
 	}
 	
 	int16_t getX(unsigned char i){
@@ -118,7 +169,19 @@ struct poseState poses[BONES_MAX_COUNT];
 sf::Transform globalTransforms[BONES_MAX_COUNT];
 float globalTransformMat3s[9 * BONES_MAX_COUNT];
 
-bool poseUpload = false;
+// Global transforms as 2x3 affines over int16 normalized coordinates: x' = a x + c y + tx, y' = b x + d y + ty
+#define AFFINE_A 0
+#define AFFINE_C 1
+#define AFFINE_TX 2
+#define AFFINE_B 3
+#define AFFINE_D 4
+#define AFFINE_TY 5
+#define AFFINE_VALUE_COUNT 6
+
+float globalAffines[AFFINE_VALUE_COUNT * BONES_MAX_COUNT];
+
+// One past the highest bone whose uploaded matrix is stale, uploads covering only that prefix
+unsigned int poseUploadEnd = BONES_MAX_COUNT;
 
 namespace pose{
 	enum transformOp (*opType)();
@@ -145,6 +208,7 @@ namespace pose{
 		}
 		
 		poseModified = true;
+		++skeletonRevision;
 	}
 	
 	void setModifiers(enum transformOp (*type)(),bool (*active)(),int32_t (*valX)(),int32_t (*valY)(),float (*valScalar)()){
@@ -214,6 +278,7 @@ namespace pose{
 		
 		poseBoneModified[j] = true;
 		poseModified = true;
+		++skeletonRevision;
 	}
 	
 	void clearUnappliedModifiers(){
@@ -228,6 +293,7 @@ namespace pose{
 		}
 		
 		poseModified = true;
+		++skeletonRevision;
 	}
 	
 	sf::Vector2<int32_t> getBonePosition(unsigned char bone){
@@ -239,23 +305,168 @@ namespace pose{
 		return sf::Vector2<int32_t>(vw::norm::toI_u(tPos.x),vw::norm::toI_u(tPos.y));
 	}
 	
+	#ifdef SKIN_SSE2
+	// Up to four x/y pairs through their bones' affines, the one path every skinned position takes
+	void skinLanes(const int16_t *xy,const unsigned char *laneBones,unsigned int lanes,int32_t *outXY){
+		__m128i pairs;
+		
+		if(lanes == 4){
+			pairs = _mm_loadu_si128((const __m128i *)xy);
+		}else{
+			int16_t padded[8] = {0};
+			memcpy(padded,xy,lanes * 2 * sizeof(int16_t));
+			
+			pairs = _mm_loadu_si128((const __m128i *)padded);
+		}
+		
+		// Pairs as 32-bit lanes: x sign-extended from the low half, y from the high
+		__m128 vX = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(pairs,16),16));
+		__m128 vY = _mm_cvtepi32_ps(_mm_srai_epi32(pairs,16));
+		
+		// Runs on one bone broadcast its affine, mixed lanes gather theirs
+		__m128 m[AFFINE_VALUE_COUNT];
+		const float *affines[4];
+		
+		for(unsigned int k = 0;k < 4;++k){
+			affines[k] = globalAffines + (k < lanes ? laneBones[k] & BONE_INDEX_MASK : 0) * AFFINE_VALUE_COUNT;
+		}
+		
+		if(lanes == 4 && affines[0] == affines[1] && affines[0] == affines[2] && affines[0] == affines[3]){
+			for(unsigned int e = 0;e < AFFINE_VALUE_COUNT;++e){
+				m[e] = _mm_set1_ps(affines[0][e]);
+			}
+		}else{
+			for(unsigned int e = 0;e < AFFINE_VALUE_COUNT;++e){
+				m[e] = _mm_setr_ps(affines[0][e],affines[1][e],affines[2][e],affines[3][e]);
+			}
+		}
+		
+		__m128 outX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[AFFINE_A],vX),_mm_mul_ps(m[AFFINE_C],vY)),m[AFFINE_TX]);
+		__m128 outY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[AFFINE_B],vX),_mm_mul_ps(m[AFFINE_D],vY)),m[AFFINE_TY]);
+		
+		// Truncated, then interleaved into x/y pairs
+		__m128i intX = _mm_cvttps_epi32(outX);
+		__m128i intY = _mm_cvttps_epi32(outY);
+		
+		if(lanes == 4){
+			_mm_storeu_si128((__m128i *)(outXY + 0),_mm_unpacklo_epi32(intX,intY));
+			_mm_storeu_si128((__m128i *)(outXY + 4),_mm_unpackhi_epi32(intX,intY));
+		}else{
+			int32_t padded[8];
+			
+			_mm_storeu_si128((__m128i *)(padded + 0),_mm_unpacklo_epi32(intX,intY));
+			_mm_storeu_si128((__m128i *)(padded + 4),_mm_unpackhi_epi32(intX,intY));
+			
+			memcpy(outXY,padded,lanes * 2 * sizeof(int32_t));
+		}
+	}
+	#endif
+	
 	sf::Vector2<int32_t> getPointPosition(unsigned char bone,int16_t x,int16_t y){
-		sf::Vector2f tPos = globalTransforms[bone & BONE_INDEX_MASK].transformPoint(vw::norm::toD(x),vw::norm::toD(y));
+		#ifdef SKIN_SSE2
+		// Through the batch kernel's lanes, so single and batched positions round alike
+		int16_t xy[2] = {x,y};
+		int32_t out[2];
 		
-		return sf::Vector2<int32_t>(vw::norm::toI_u(tPos.x),vw::norm::toI_u(tPos.y));
+		skinLanes(xy,&bone,1,out);
+		
+		return sf::Vector2<int32_t>(out[0],out[1]);
+		#else
+		const float *m = globalAffines + (bone & BONE_INDEX_MASK) * AFFINE_VALUE_COUNT;
+		
+		return sf::Vector2<int32_t>(
+			(int32_t)(m[AFFINE_A] * x + m[AFFINE_C] * y + m[AFFINE_TX]),
+			(int32_t)(m[AFFINE_B] * x + m[AFFINE_D] * y + m[AFFINE_TY])
+		);
+		#endif
 	}
 	
-	void composeParent(unsigned char parent){
-		// Self composition
-		globalTransforms[parent] *= poses[parent].transformation;
+	void skinVerts(const struct vecTrisBuf *buf,unsigned int first,unsigned int count,int32_t *outXY){
+		#ifdef SKIN_SSE2
+		// Four vertices at a time, the tail padded through the same lanes
+		unsigned char laneBones[4];
 		
-		// Recursive walk down the tree
-		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
-			if(boneArray[i].parent == parent){
-				globalTransforms[i] *= globalTransforms[parent];
-				composeParent(i);
+		for(unsigned int i = 0;i < count;i += 4){
+			unsigned int lanes = count - i < 4 ? count - i : 4;
+			
+			for(unsigned int k = 0;k < lanes;++k){
+				laneBones[k] = VERT_BONE(buf,first + i + k);
 			}
+			
+			skinLanes(&VERT_X(buf,first + i),laneBones,lanes,outXY + i * 2);
+		}
+		#else
+		for(unsigned int i = 0;i < count;++i){
+			sf::Vector2<int32_t> p = getPointPosition(VERT_BONE(buf,first + i),VERT_X(buf,first + i),VERT_Y(buf,first + i));
+			
+			outXY[i * 2 + 0] = p.x;
+			outXY[i * 2 + 1] = p.y;
 		}
+		#endif
+	}
+	
+	void skinBenchmark(unsigned int vertCount,double *runMVerts,double *mixedMVerts){
+		// Synthetic vertices on the live pose, bones in runs of 64 then shuffled per vertex
+		std::vector<int16_t> xy(vertCount * 2);
+		std::vector<uint8_t> tbc(vertCount * 3);
+		std::vector<int32_t> out(vertCount * 2);
+		
+		struct vecTrisBuf buf;
+		buf.xy = &xy[0];
+		buf.tbc = &tbc[0];
+		
+		for(unsigned int v = 0;v < vertCount;++v){
+			VERT_X(&buf,v) = (int16_t)(v * 7919);
+			VERT_Y(&buf,v) = (int16_t)(v * 104729);
+		}
+		
+		double *results[2] = {runMVerts,mixedMVerts};
+		
+		for(unsigned int pass = 0;pass < 2;++pass){
+			for(unsigned int v = 0;v < vertCount;++v){
+				VERT_BONE(&buf,v) = (pass == 0 ? v / 64 : v * 2654435761u >> 27) % BONES_MAX_COUNT;
+			}
+			
+			// Repeated until timing is meaningful
+			sf::Clock clock;
+			unsigned long long skinned = 0;
+			
+			do{
+				skinVerts(&buf,0,vertCount,&out[0]);
+				skinned += vertCount;
+			}while(clock.getElapsedTime().asMilliseconds() < SKIN_BENCHMARK_MILLISECONDS);
+			
+			*results[pass] = skinned / (double)clock.getElapsedTime().asMicroseconds();
+		}
+	}
+	
+	void packGlobal(unsigned int i){
+		// Set Mat3 for uploading, only bones whose matrix actually changed extending the upload
+		const float *currGlobalMat = globalTransforms[i].getMatrix();
+		
+		float mat3[9] = {
+			currGlobalMat[0],currGlobalMat[1],currGlobalMat[3],
+			currGlobalMat[4],currGlobalMat[5],currGlobalMat[7],
+			currGlobalMat[12],currGlobalMat[13],currGlobalMat[15]
+		};
+		
+		if(memcmp(globalTransformMat3s + i * 9,mat3,sizeof(mat3)) != 0){
+			memcpy(globalTransformMat3s + i * 9,mat3,sizeof(mat3));
+			
+			if(i + 1 > poseUploadEnd){
+				poseUploadEnd = i + 1;
+			}
+		}
+		
+		// Set affine for CPU skinning, translation scaled into int16 units
+		float *affine = globalAffines + i * AFFINE_VALUE_COUNT;
+		
+		affine[AFFINE_A] = currGlobalMat[0];
+		affine[AFFINE_C] = currGlobalMat[4];
+		affine[AFFINE_TX] = currGlobalMat[12] * (float)INT16_MAX;
+		affine[AFFINE_B] = currGlobalMat[1];
+		affine[AFFINE_D] = currGlobalMat[5];
+		affine[AFFINE_TY] = currGlobalMat[13] * (float)INT16_MAX;
 	}
 	
 	void update(){
@@ -263,8 +474,12 @@ namespace pose{
 			return;
 		}
 		
+		bool recompose[BONES_MAX_COUNT];
+		
 		// Local transformation update calculations
 		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			recompose[i] = poseBoneModified[i];
+			
 			if(!poseBoneModified[i]){
 				continue;
 			}
@@ -290,46 +505,93 @@ namespace pose{
 			poseBoneModified[i] = false;
 		}
 		
-		// Global transformation calculations
-		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
-			globalTransforms[i] = sf::Transform::Identity;
-		}
+		// Global transformation calculations, in one pass over the preorder
+		// Only subtrees beneath modified bones are recomposed, parents always preceding children
+		unsigned int dirtyEnd = 0;
 		
-		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
-			if(boneArray[i].parent >= BONES_MAX_COUNT){
-				composeParent(i);
+		for(unsigned int o = 0;o < BONES_MAX_COUNT;++o){
+			unsigned char i = boneOrder[o];
+			
+			if(recompose[i] && o + boneSubtreeSizes[i] > dirtyEnd){
+				dirtyEnd = o + boneSubtreeSizes[i];
 			}
-		}
-		
-		// Set Mat3s for uploading
-		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
-			const float *currGlobalMat = globalTransforms[i].getMatrix();
 			
-			globalTransformMat3s[i * 9 + 0] = currGlobalMat[0];
-			globalTransformMat3s[i * 9 + 1] = currGlobalMat[1];
-			globalTransformMat3s[i * 9 + 2] = currGlobalMat[3];
+			if(o >= dirtyEnd){
+				continue;
+			}
 			
-			globalTransformMat3s[i * 9 + 3] = currGlobalMat[4];
-			globalTransformMat3s[i * 9 + 4] = currGlobalMat[5];
-			globalTransformMat3s[i * 9 + 5] = currGlobalMat[7];
+			if(boneArray[i].parent < BONES_MAX_COUNT){
+				globalTransforms[i] = globalTransforms[boneArray[i].parent] * poses[i].transformation;
+			}else{
+				globalTransforms[i] = poses[i].transformation;
+			}
 			
-			globalTransformMat3s[i * 9 + 6] = currGlobalMat[12];
-			globalTransformMat3s[i * 9 + 7] = currGlobalMat[13];
-			globalTransformMat3s[i * 9 + 8] = currGlobalMat[15];
+			packGlobal(i);
 		}
 		
 		// Set flags
 		poseModified = false;
-		poseUpload = true;
+	}
+	
+	// Animation sampling ---------------------------------------------------
+	unsigned int revision(){
+		return skeletonRevision;
+	}
+	
+	void edited(){
+		++skeletonRevision;
+	}
+	
+	void getLocal(unsigned char bone,int32_t *translateX,int32_t *translateY,float *scale,float *rotation){
+		unsigned char j = bone & BONE_INDEX_MASK;
+		
+		*translateX = poses[j].translateX;
+		*translateY = poses[j].translateY;
+		*scale = poses[j].scale;
+		*rotation = poses[j].rotation;
+	}
+	
+	void setLocal(unsigned char bone,int32_t translateX,int32_t translateY,float scale,float rotation){
+		unsigned char j = bone & BONE_INDEX_MASK;
+		
+		poses[j].translateX = translateX;
+		poses[j].translateY = translateY;
+		poses[j].scale = scale;
+		poses[j].rotation = rotation;
+		
+		poseBoneModified[j] = true;
+		poseModified = true;
+	}
+	
+	void getGlobals(sf::Transform *out){
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			out[i] = globalTransforms[i];
+		}
+	}
+	
+	void setGlobals(const sf::Transform *in){
+		for(unsigned int i = 0;i < BONES_MAX_COUNT;++i){
+			globalTransforms[i] = in[i];
+			packGlobal(i);
+			
+			// Local transformations are left stale, to be fully recomputed upon the next change
+			poseBoneModified[i] = true;
+		}
+		
+		poseModified = false;
 	}
 	
 	void upload(){
-		if(!poseUpload){
+		if(poseUploadEnd == 0){
 			return;
 		}
 		
-		uniformBones(globalTransformMat3s,BONES_MAX_COUNT);
-		poseUpload = false;
+		uniformBones(globalTransformMat3s,poseUploadEnd);
+		poseUploadEnd = 0;
+	}
+	
+	void reupload(){
+		poseUploadEnd = BONES_MAX_COUNT;
 	}
 	
 	void draw(){
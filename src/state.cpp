@@ -51,6 +51,7 @@ namespace state{
 				break;
 			case STATE_POSE:
 			case STATE_ATOP_TRANSFORM_POSE:
+			case STATE_ATOP_IK_POSE:
 				currDrawState = D_STATE_POSE;
 				
 				break;
@@ -1,4 +1,10 @@
 #include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define TROP_SSE2
+	#include <emmintrin.h>
+#endif
 
 #include "transformOp.hpp"
 #include "graphics.hpp"
@@ -16,6 +22,12 @@ namespace trOp{
 	int32_t handleX,handleY;
 	int32_t lastX,lastY;
 	
+	// Resolved transformation: v' = M * (v - pivot) + offset, truncated and saturated to int16
+	float matA,matB,matC,matD;
+	int32_t pivotX,pivotY;
+	int32_t offsetX,offsetY;
+	bool identity = true;
+	
 	// Private derivative values
 	int32_t distHX(){
 		return handleX - srcX;
@@ -58,6 +70,57 @@ namespace trOp{
 		return opState;
 	}
 	
+	// Resolution, once per change rather than once per vertex
+	void resolve(){
+		matA = 1.0;
+		matB = 0.0;
+		matC = 0.0;
+		matD = 1.0;
+		
+		pivotX = 0;
+		pivotY = 0;
+		offsetX = 0;
+		offsetY = 0;
+		
+		identity = (opState != TROP_STATE_UPDATE || (distLX() == 0 && distLY() == 0));
+		
+		if(identity){
+			return;
+		}
+		
+		float angle,scale;
+		
+		switch(op){
+			case TROP_TRANSLATE:
+				offsetX = distLX();
+				offsetY = distLY();
+				
+				break;
+			case TROP_ROTATE:
+				angle = angleLH();
+				
+				matA = cos(angle);
+				matB = -sin(angle);
+				matC = sin(angle);
+				matD = cos(angle);
+				
+				pivotX = offsetX = srcX;
+				pivotY = offsetY = srcY;
+				
+				break;
+			case TROP_SCALE:
+				scale = scaleLH();
+				
+				matA = scale;
+				matD = scale;
+				
+				pivotX = offsetX = srcX;
+				pivotY = offsetY = srcY;
+				
+				break;
+		}
+	}
+	
 	// Operations
 	bool dirty(){
 		return (opState == TROP_STATE_UPDATE);
@@ -84,6 +147,8 @@ namespace trOp{
 				break;
 		}
 		
+		resolve();
+		
 		return true;
 	}
 	
@@ -100,13 +165,20 @@ namespace trOp{
 		handleY = y;
 		
 		opState = TROP_STATE_UPDATE;
+		resolve();
 		
 		return true;
 	}
 	
 	void update(int32_t x,int32_t y){
+		if(x == lastX && y == lastY){
+			return;
+		}
+		
 		lastX = x;
 		lastY = y;
+		
+		resolve();
 	}
 	
 	int32_t valX(){
@@ -143,73 +215,110 @@ namespace trOp{
 	}
 	
 	// Private constrained operation helper functions
-	void constrainedSet(int16_t *var,int32_t val){
+	int16_t constrained(int32_t val){
 		if(val > INT16_MAX){
-			*var = INT16_MAX;
+			return INT16_MAX;
 		}else if(val < INT16_MIN){
-			*var = INT16_MIN;
-		}else{
-			*var = val;
+			return INT16_MIN;
 		}
+		
+		return val;
 	}
 	
-	void constrainedAdd(int16_t *var,int32_t val){
-		constrainedSet(var,(int32_t)*var + val);
-	}
+	// Bound ahead of integer conversion, leaving room for the offset
+	#define TROP_FLOAT_BOUND 1073741824.0f
 	
-	void constrainedRotate(int16_t *x,int16_t *y,float angle){
-		int32_t newX = (float)(*x) * cos(angle) - (float)(*y) * sin(angle);
-		int32_t newY = (float)(*x) * sin(angle) + (float)(*y) * cos(angle);
-		
-		constrainedSet(x,newX);
-		constrainedSet(y,newY);
+	int32_t truncated(float val){
+		return (int32_t)fminf(fmaxf(val,-TROP_FLOAT_BOUND),TROP_FLOAT_BOUND);
 	}
 	
 	// Application operations
 	void apply(int16_t *x,int16_t *y){
-		if(opState != TROP_STATE_UPDATE){
+		if(identity){
 			return;
 		}
 		
-		if(distLX() == 0 && distLY() == 0){
+		float dX = (float)((int32_t)*x - pivotX);
+		float dY = (float)((int32_t)*y - pivotY);
+		
+		*x = constrained(truncated(matA * dX + matB * dY) + offsetX);
+		*y = constrained(truncated(matC * dX + matD * dY) + offsetY);
+	}
+	
+	void applyBatch(int16_t *xy,const unsigned char *mask,unsigned int count,uint16_t flip){
+		if(identity){
 			return;
 		}
 		
-		// Operation
-		int32_t pX,pY;
+		unsigned int i = 0;
 		
-		switch(op){
-			case TROP_TRANSLATE:
-				constrainedAdd(x,distLX());
-				constrainedAdd(y,distLY());
-				
-				break;
-			case TROP_ROTATE:
-				*x -= srcX;
-				*y -= srcY;
-				
-				constrainedRotate(x,y,angleLH());
-				
-				constrainedAdd(x,srcX);
-				constrainedAdd(y,srcY);
-				
-				break;
-			case TROP_SCALE:
-				pX = (float)(*x - srcX) * scaleLH();
-				pY = (float)(*y - srcY) * scaleLH();
-				
-				*x = srcX;
-				*y = srcY;
-				
-				constrainedAdd(x,pX);
-				constrainedAdd(y,pY);
-				
-				break;
+		#ifdef TROP_SSE2
+		// Four x/y pairs at a time: [x y x y] * [a d a d] + [y x y x] * [b c b c]
+		const __m128 m0 = _mm_setr_ps(matA,matD,matA,matD);
+		const __m128 m1 = _mm_setr_ps(matB,matC,matB,matC);
+		const __m128 pivot = _mm_setr_ps(pivotX,pivotY,pivotX,pivotY);
+		const __m128 bound = _mm_set1_ps(TROP_FLOAT_BOUND);
+		const __m128 boundNeg = _mm_set1_ps(-TROP_FLOAT_BOUND);
+		const __m128i offset = _mm_setr_epi32(offsetX,offsetY,offsetX,offsetY);
+		const __m128i flipped = _mm_set1_epi16((int16_t)flip);
+		const __m128i zero = _mm_setzero_si128();
+		
+		for(;i + 4 <= count;i += 4){
+			int32_t maskBits;
+			memcpy(&maskBits,mask + i,sizeof(maskBits));
+			
+			if(maskBits == 0){
+				continue;
+			}
+			
+			__m128i raw = _mm_loadu_si128((__m128i *)(xy + i * 2));
+			__m128i vals = _mm_xor_si128(raw,flipped);
+			
+			// Sign-extended to int32, then float relative to the pivot
+			__m128 lo = _mm_sub_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(vals,vals),16)),pivot);
+			__m128 hi = _mm_sub_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(vals,vals),16)),pivot);
+			
+			lo = _mm_add_ps(_mm_mul_ps(lo,m0),_mm_mul_ps(_mm_shuffle_ps(lo,lo,_MM_SHUFFLE(2,3,0,1)),m1));
+			hi = _mm_add_ps(_mm_mul_ps(hi,m0),_mm_mul_ps(_mm_shuffle_ps(hi,hi,_MM_SHUFFLE(2,3,0,1)),m1));
+			
+			lo = _mm_min_ps(_mm_max_ps(lo,boundNeg),bound);
+			hi = _mm_min_ps(_mm_max_ps(hi,boundNeg),bound);
+			
+			// Truncated, offset, and saturated back to int16
+			__m128i result = _mm_packs_epi32(
+				_mm_add_epi32(_mm_cvttps_epi32(lo),offset),
+				_mm_add_epi32(_mm_cvttps_epi32(hi),offset)
+			);
+			
+			result = _mm_xor_si128(result,flipped);
+			
+			// Unselected pairs keep their raw values
+			__m128i sel = _mm_cvtsi32_si128(maskBits);
+			sel = _mm_unpacklo_epi8(sel,sel);
+			sel = _mm_cmpeq_epi16(_mm_unpacklo_epi16(sel,sel),zero);
+			
+			_mm_storeu_si128((__m128i *)(xy + i * 2),_mm_or_si128(_mm_and_si128(sel,raw),_mm_andnot_si128(sel,result)));
+		}
+		#endif
+		
+		for(;i < count;++i){
+			if(!mask[i]){
+				continue;
+			}
+			
+			int16_t x = xy[i * 2] ^ flip;
+			int16_t y = xy[i * 2 + 1] ^ flip;
+			
+			apply(&x,&y);
+			
+			xy[i * 2] = x ^ flip;
+			xy[i * 2 + 1] = y ^ flip;
 		}
 	}
 	
 	void exit(){
 		opState = TROP_STATE_NONE;
+		resolve();
 	}
 	
 	void drawUI(){
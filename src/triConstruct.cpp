@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 
 #include "state.hpp"
 #include "triConstruct.hpp"
@@ -24,6 +25,10 @@ namespace triCn{
 	uint16_t constructUV[TRI_UV_VALUE_COUNT];
 	uint8_t constructTBC[TRI_TBC_VALUE_COUNT];
 	
+	// Contents of constructTri, which is only reloaded when they change
+	int16_t uploadedXY[TRI_XY_VALUE_COUNT];
+	unsigned char uploadedType;
+	
 	// Initialization / Destruction
 	void init(){
 		constructBuf.count = 1;
@@ -34,6 +39,7 @@ namespace triCn{
 	
 	void free(){
 		deleteVecTris(constructTri);
+		constructTri = NULL;
 	}
 	
 	// Triangle building
@@ -93,8 +99,17 @@ namespace triCn{
 				VERT_COLOR(&constructBuf,i) = CLR_EDITR_OFFWHITE;
 			}
 			
-			// Drawing
-			render::loadAndDrawTris(&constructBuf,&constructTri,VERT_MODE_RAW_XY,FRAG_MODE_CLIPPED_CLR,CLR_PFL_EDITOR,wireframe);
+			// Drawing, reusing the loaded triangle while the preview is unchanged
+			struct vecTrisBuf *reload = NULL;
+			
+			if(constructTri == NULL || triType != uploadedType || memcmp(constructXY,uploadedXY,sizeof(constructXY)) != 0){
+				memcpy(uploadedXY,constructXY,sizeof(constructXY));
+				uploadedType = triType;
+				
+				reload = &constructBuf;
+			}
+			
+			render::loadAndDrawTris(reload,&constructTri,VERT_MODE_RAW_XY,FRAG_MODE_CLIPPED_CLR,CLR_PFL_EDITOR,0,wireframe,0.0,0.0);
 		}
 		
 		// Draw vertices placed
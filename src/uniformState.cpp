@@ -0,0 +1,130 @@
+extern "C" {
+	#include <vecGL/shader.h>
+}
+
+#include "uniformState.hpp"
+
+namespace unif{
+	// Last uploaded values, only valid once set
+	struct floatBlock{
+		float v[4];
+		bool valid;
+	};
+	
+	struct floatBlock posState,fParamsVState,ssrState;
+	
+	uint32_t colorState;
+	bool colorValid;
+	
+	const uint32_t *colorArrayPtr;
+	unsigned int colorArrayCount,colorArrayVersion;
+	bool colorArrayValid;
+	
+	unsigned int vertState,fragState;
+	bool modesValid;
+	
+	unsigned long issuedCount = 0;
+	unsigned long skippedCount = 0;
+	
+	bool changed(struct floatBlock *block,float x,float y,float z,float w){
+		if(block->valid && block->v[0] == x && block->v[1] == y && block->v[2] == z && block->v[3] == w){
+			++skippedCount;
+			return false;
+		}
+		
+		block->v[0] = x;
+		block->v[1] = y;
+		block->v[2] = z;
+		block->v[3] = w;
+		block->valid = true;
+		
+		++issuedCount;
+		return true;
+	}
+	
+	void invalidate(){
+		posState.valid = false;
+		fParamsVState.valid = false;
+		ssrState.valid = false;
+		
+		colorValid = false;
+		colorArrayValid = false;
+		modesValid = false;
+	}
+	
+	// Uniforms ---------------------------------------------------
+	void position(float x,float y){
+		if(changed(&posState,x,y,0.0,0.0)){
+			uniformPosition(x,y);
+		}
+	}
+	
+	void fParamsV(float x,float y,float z,float w){
+		if(changed(&fParamsVState,x,y,z,w)){
+			uniformFParamsV(x,y,z,w);
+		}
+	}
+	
+	void ssr(float x,float y,float r){
+		if(changed(&ssrState,x,y,r,0.0)){
+			uniformSSR(x,y,r);
+		}
+	}
+	
+	void color(uint32_t c){
+		if(colorValid && colorState == c){
+			++skippedCount;
+			return;
+		}
+		
+		colorState = c;
+		colorValid = true;
+		
+		++issuedCount;
+		uniformColor_u32(c);
+	}
+	
+	void colorArray(const uint32_t *colors,unsigned int count,unsigned int version){
+		// Arrays are identified by their storage and a version bumped on every change
+		if(colorArrayValid && colorArrayPtr == colors && colorArrayCount == count && colorArrayVersion == version){
+			++skippedCount;
+			return;
+		}
+		
+		colorArrayPtr = colors;
+		colorArrayCount = count;
+		colorArrayVersion = version;
+		colorArrayValid = true;
+		
+		++issuedCount;
+		uniformColorArray_u32((uint32_t *)colors,count);
+	}
+	
+	void vertFragModes(unsigned int vert,unsigned int frag){
+		if(modesValid && vertState == vert && fragState == frag){
+			++skippedCount;
+			return;
+		}
+		
+		vertState = vert;
+		fragState = frag;
+		modesValid = true;
+		
+		++issuedCount;
+		uniformVertFragModes(vert,frag);
+	}
+	
+	// Statistics ---------------------------------------------------
+	unsigned long issued(){
+		return issuedCount;
+	}
+	
+	unsigned long skipped(){
+		return skippedCount;
+	}
+	
+	void statsReset(){
+		issuedCount = 0;
+		skippedCount = 0;
+	}
+}
@@ -1,10 +1,7 @@
 #include <cmath>
 
-extern "C" {
-	#include <vecGL/shader.h>
-}
-
 #include "view.hpp"
+#include "uniformState.hpp"
 
 namespace vw{
 	// State ---------------------------------------------------------------------------
@@ -215,10 +212,10 @@ namespace vw{
 				sf::Vector2f panPos = lastPanPos + deltaPanPos;
 				panPos = panPos / (normScale * zoomScale);
 				
-				uniformPosition(offsetX + panPos.x,offsetY - panPos.y);
-				uniformFParamsV(relScaleX,relScaleY,0.0,0.0);
+				unif::position(offsetX + panPos.x,offsetY - panPos.y);
+				unif::fParamsV(relScaleX,relScaleY,0.0,0.0);
 				
-				uniformSSR(
+				unif::ssr(
 					zoomScale * normScale * 2.0 / (float)target.getSize().x,
 					zoomScale * normScale * 2.0 / (float)target.getSize().y,
 					0.0